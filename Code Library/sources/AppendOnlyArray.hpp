@@ -0,0 +1,212 @@
+/** \file AppendOnlyArray.hpp
+ * Growing sorted array with one appending writer and lock-free concurrent readers.
+ */
+
+/*
+ *  AppendOnlyArray.hpp
+ *
+ *  Instituto de Informatica - UFG
+ *
+ */
+
+/*
+ * Elements are stored in segments of geometrically growing size: segment s holds first_segment << s
+ * elements, so no element is ever moved or copied once it is written and the segment directory has a
+ * fixed number of entries. The writer stores the element (and, at a segment boundary, the new segment
+ * pointer) and only then publishes the new length with a release store. A reader loads the length with
+ * an acquire load and gets a snapshot: every element below that length is complete and will never change,
+ * so readers take no locks and never wait for the writer.
+ *
+ * Segments are only released by the destructor, so snapshots need no grace period; they must not be used
+ * after the array is destroyed. Only one thread may append at a time.
+ */
+
+#ifndef AppendOnlyArray_hpp
+#define AppendOnlyArray_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "InstanceView.hpp"
+
+#define APPEND_FIRST_SEGMENT 1024 /* Elements of the first segment; rounded up to a power of two. */
+#define APPEND_MAX_SEGMENTS 48
+
+/*!
+ * \brief Append-only sorted array: one writer appends non-decreasing keys while any number of readers search it.
+ */
+template<class T>
+class AppendOnlyArray{
+public:
+    /*!
+     * \brief Consistent read-only view of the first size() elements.
+     *
+     * begin() and end() are random access iterators, so a snapshot can be passed to the 1D searches of
+     * SearchAlgorithms.hpp, e.g. exponential_search(s.begin(), s.end(), value).
+     */
+    class Snapshot{
+    public:
+        typedef IndexedIterator<Snapshot> iterator;
+
+        Snapshot() : array(0), n(0){}
+        Snapshot(const AppendOnlyArray* array, std::size_t n) : array(array), n(n){}
+
+        const T& operator[](std::ptrdiff_t i) const{ return array->at(i); }
+        std::size_t size() const{ return n; }
+        iterator begin() const{ return iterator(*this, 0); }
+        iterator end() const{ return iterator(*this, n); }
+
+        /*!
+         * \brief Position of the first element not less than value, or size() if there is none.
+         *
+         * The segment is found by comparing value with the first element of each segment, and the
+         * position is then found by binary search inside that segment, on contiguous memory.
+         */
+        std::size_t lower_bound(const T& value) const{
+            if(n == 0)
+                return 0;
+            if(!(array->segment(0)[0] < value))
+                return 0;
+            /* Last segment whose first element is less than value. */
+            int lo = 0, hi = array->segment_of(n - 1);
+            while(lo < hi){
+                int mid = (lo + hi + 1) / 2;
+                if(array->segment(mid)[0] < value)
+                    lo = mid;
+                else
+                    hi = mid - 1;
+            }
+            int s = lo;
+            std::size_t start = array->segment_start(s);
+            std::size_t len = std::min(array->segment_size(s), n - start);
+            const T* p = array->segment(s);
+            return start + (std::lower_bound(p, p + len, value) - p);
+        }
+
+        /*!
+         * \brief Tells whether value is one of the elements of the snapshot.
+         */
+        bool contains(const T& value) const{
+            std::size_t i = lower_bound(value);
+            return i < n && !(value < array->at(i));
+        }
+
+    private:
+        const AppendOnlyArray* array;
+        std::size_t n;
+    };
+
+    /*!
+     * \param first_segment number of elements of the first segment.
+     */
+    explicit AppendOnlyArray(std::size_t first_segment = APPEND_FIRST_SEGMENT) : length(0){
+        shift = 0;
+        while(((std::size_t)1 << shift) < first_segment)
+            ++shift;
+        for( int s = 0; s < APPEND_MAX_SEGMENTS; ++s)
+            segments[s].store(0, std::memory_order_relaxed);
+        count = 0;
+    }
+
+    ~AppendOnlyArray(){
+        for( int s = 0; s < APPEND_MAX_SEGMENTS; ++s)
+            delete[] segments[s].load(std::memory_order_relaxed);
+    }
+
+    AppendOnlyArray(const AppendOnlyArray&) = delete;
+    AppendOnlyArray& operator=(const AppendOnlyArray&) = delete;
+
+    /*!
+     * \brief Appends one key and publishes it. Writer thread only.
+     * \return false, without appending, if value is less than the last key.
+     */
+    bool append(const T& value){
+        if(!push(value))
+            return false;
+        length.store(count, std::memory_order_release);
+        return true;
+    }
+
+    /*!
+     * \brief Appends the keys of [first, last) and publishes them together. Writer thread only.
+     * \return number of keys appended; it stops at the first key less than its predecessor.
+     */
+    template<class InputIt>
+    std::size_t append(InputIt first, InputIt last){
+        std::size_t before = count;
+        for( ; first != last; ++first)
+            if(!push(*first))
+                break;
+        length.store(count, std::memory_order_release);
+        return count - before;
+    }
+
+    /*!
+     * \brief Number of published elements.
+     */
+    std::size_t size() const{ return length.load(std::memory_order_acquire); }
+
+    /*!
+     * \brief Snapshot of the published elements; it stays valid while more keys are appended.
+     */
+    Snapshot snapshot() const{ return Snapshot(this, size()); }
+
+    /*!
+     * \brief Element i; i must be less than a size() already observed.
+     */
+    const T& operator[](std::size_t i) const{ return at(i); }
+
+    bool contains(const T& value) const{ return snapshot().contains(value); }
+
+    /*!
+     * \brief Bytes allocated by the segments.
+     */
+    std::size_t memory() const{
+        std::size_t bytes = 0;
+        for( int s = 0; s < APPEND_MAX_SEGMENTS; ++s)
+            if(segments[s].load(std::memory_order_relaxed))
+                bytes += segment_size(s) * sizeof(T);
+        return bytes;
+    }
+
+private:
+    bool push(const T& value){
+        if(count > 0 && value < at(count - 1))
+            return false;
+        int s = segment_of(count);
+        if(s >= APPEND_MAX_SEGMENTS)
+            return false;
+        T* p = segments[s].load(std::memory_order_relaxed);
+        if(p == 0){
+            p = new T[segment_size(s)];
+            /* Ordered before the readers see it by the release store of the length. */
+            segments[s].store(p, std::memory_order_relaxed);
+        }
+        p[count - segment_start(s)] = value;
+        ++count;
+        return true;
+    }
+
+    int segment_of(std::size_t i) const{
+        std::uint64_t j = (std::uint64_t)(i >> shift) + 1;
+        return 63 - __builtin_clzll(j);
+    }
+
+    std::size_t segment_start(int s) const{ return (((std::size_t)1 << s) - 1) << shift; }
+    std::size_t segment_size(int s) const{ return (std::size_t)1 << (shift + s); }
+    const T* segment(int s) const{ return segments[s].load(std::memory_order_relaxed); }
+
+    const T& at(std::size_t i) const{
+        int s = segment_of(i);
+        return segment(s)[i - segment_start(s)];
+    }
+
+    std::atomic<T*> segments[APPEND_MAX_SEGMENTS];
+    int shift;
+    std::size_t count; /* Elements written; only the writer reads it. */
+    alignas(64) std::atomic<std::size_t> length; /* Elements published to the readers. */
+};
+
+#endif
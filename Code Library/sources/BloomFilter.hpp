@@ -0,0 +1,249 @@
+/** \file BloomFilter.hpp
+ * Blocked Bloom filter used to reject absent keys before the two- and three-dimensional searches.
+ */
+
+/*
+ *  BloomFilter.hpp
+ *
+ *  Instituto de Informatica - UFG
+ *
+ */
+
+/*
+ * The filter is an array of 512-bit blocks, one cache line each. A key selects one block with its hash
+ * and sets or tests k bits inside it, so a query reads a single cache line. With b bits per key the false
+ * positive rate is close to that of a classic Bloom filter with the same size: about 1% for b = 10, k = 7.
+ * A negative answer is exact; a positive one is confirmed by the search.
+ */
+
+#ifndef BloomFilter_hpp
+#define BloomFilter_hpp
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "SearchAlgorithms.hpp"
+
+#define BLOOM_BLOCK_BITS 512
+
+/*!
+ * \brief Blocked Bloom filter over the keys of an instance.
+ */
+template<class T>
+class BloomFilter{
+public:
+    BloomFilter() : k(0), bpk(0), keys(0), seconds(0){}
+
+    /*!
+     * \brief Empty filter sized for n keys.
+     * \param n expected number of keys.
+     * \param bits_per_key filter bits per key; memory is n * bits_per_key / 8 bytes.
+     * \param hashes bits set per key (0 to choose bits_per_key * ln 2).
+     */
+    BloomFilter(std::size_t n, double bits_per_key = 10, int hashes = 0) : seconds(0){
+        init(n, bits_per_key, hashes);
+    }
+
+    /*!
+     * \brief Filter of a one-dimensional array.
+     * \param first iterator to start of array.
+     * \param last iterator to end of array.
+     */
+    template<class ForwardIt>
+    void build(ForwardIt first, ForwardIt last, double bits_per_key = 10, int hashes = 0){
+        std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+        init(last - first, bits_per_key, hashes);
+        for( ForwardIt it = first; it != last; ++it)
+            insert(*it);
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t).count();
+    }
+
+    /*!
+     * \brief Filter of a two-dimensional array.
+     * \param first iterator to start of array.
+     * \param last iterator to end of array.
+     */
+    template<class ForwardIt>
+    void build_2D(ForwardIt first, ForwardIt last, double bits_per_key = 10, int hashes = 0){
+        std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+        int m = last - first, n = m > 0? first[0].size() : 0;
+        init((std::size_t)m*n, bits_per_key, hashes);
+        for( int i = 0; i < m; ++i)
+            for( int j = 0; j < n; ++j)
+                insert(first[i][j]);
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t).count();
+    }
+
+    /*!
+     * \brief Filter of a three-dimensional array.
+     * \param first iterator to start of array.
+     * \param last iterator to end of array.
+     */
+    template<class ForwardIt>
+    void build_3D(ForwardIt first, ForwardIt last, double bits_per_key = 10, int hashes = 0){
+        std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+        int m = last - first, n = m > 0? first[0].size() : 0, p = n > 0? first[0][0].size() : 0;
+        init((std::size_t)m*n*p, bits_per_key, hashes);
+        for( int i = 0; i < m; ++i)
+            for( int j = 0; j < n; ++j)
+                for( int l = 0; l < p; ++l)
+                    insert(first[i][j][l]);
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t).count();
+    }
+
+    void insert(const T& value){
+        std::uint64_t h = hash(value);
+        Block& b = blocks[block_of(h)];
+        for( int i = 0; i < k; ++i){
+            unsigned bit = next_bit(h);
+            b.w[bit / 64] |= (std::uint64_t)1 << (bit % 64);
+        }
+    }
+
+    /*!
+     * \brief False if value is certainly not in the instance.
+     * \param  value is the search key.
+     */
+    bool may_contain(const T& value) const{
+        if(blocks.empty())
+            return false;
+        std::uint64_t h = hash(value);
+        const Block& b = blocks[block_of(h)];
+        for( int i = 0; i < k; ++i){
+            unsigned bit = next_bit(h);
+            if(!((b.w[bit / 64] >> (bit % 64)) & 1))
+                return false;
+        }
+        return true;
+    }
+
+    /*!
+     * \brief Bytes used by the filter.
+     */
+    std::size_t memory() const{ return blocks.size()*sizeof(Block); }
+
+    /*!
+     * \brief Seconds spent by the last build.
+     */
+    double build_time() const{ return seconds; }
+
+    int hashes() const{ return k; }
+    double bits_per_key() const{ return bpk; }
+
+    /*!
+     * \brief Expected false positive rate: the classic rate averaged over the Poisson load of the blocks.
+     */
+    double expected_fpr() const{
+        if(keys == 0 || blocks.empty())
+            return 0;
+        double lambda = (double)keys / blocks.size(), fpr = 0, p = std::exp(-lambda);
+        for( int i = 0; i < lambda*4 + 64; ++i){
+            fpr += p * std::pow(1 - std::pow(1 - 1.0/BLOOM_BLOCK_BITS, (double)k*i), k);
+            p *= lambda / (i+1);
+        }
+        return fpr;
+    }
+
+private:
+    struct alignas(64) Block{
+        std::uint64_t w[BLOOM_BLOCK_BITS / 64];
+    };
+
+    void init(std::size_t n, double bits_per_key, int hashes){
+        bpk = bits_per_key > 1? bits_per_key : 1;
+        k = hashes > 0? hashes : (int)(bpk * 0.6931 + 0.5);
+        if(k < 1)
+            k = 1;
+        if(k > 16)
+            k = 16;
+        keys = n;
+        std::size_t count = (std::size_t)std::ceil(n * bpk / BLOOM_BLOCK_BITS);
+        blocks.assign(count < 1? 1 : count, Block());
+    }
+
+    /* The high bits of the hash select the block; the bit positions are drawn from a stream seeded by it. */
+    std::size_t block_of(std::uint64_t& h) const{
+        std::size_t b = (std::size_t)(((unsigned __int128)h * blocks.size()) >> 64);
+        h = h * 0x9e3779b97f4a7c15ULL + 0x632be59bd9b4e019ULL;
+        return b;
+    }
+
+    static unsigned next_bit(std::uint64_t& h){
+        h = h * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (unsigned)(h >> 55) % BLOOM_BLOCK_BITS;
+    }
+
+    /* Hash of the bytes of the key; 0 and -0 are the same key. */
+    static std::uint64_t hash(T value){
+        if(value == T(0))
+            value = T(0);
+        std::uint64_t x = 0;
+        std::memcpy(&x, &value, sizeof(T) < 8? sizeof(T) : 8);
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    int k;
+    double bpk;
+    std::size_t keys;
+    double seconds;
+    std::vector<Block> blocks;
+};
+
+
+/*!
+ * \brief Saddleback search function that consults a Bloom filter first.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ * \param bf filter built with build_2D on the same array.
+ */
+template<class ForwardIt, class T, class U>
+bool saddleback_search(ForwardIt first, ForwardIt last, const T& value, const BloomFilter<U>& bf){
+    return bf.may_contain(value) && saddleback_search(first, last, value);
+}
+
+/*!
+ * \brief Shen search function that consults a Bloom filter first.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ * \param bf filter built with build_2D on the same array.
+ */
+template<class ForwardIt, class T, class U>
+bool shen_search(ForwardIt first, ForwardIt last, const T& value, const BloomFilter<U>& bf){
+    return bf.may_contain(value) && shen_search(first, last, value);
+}
+
+/*!
+ * \brief Linial and Saks search function that consults a Bloom filter first.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ * \param bf filter built with build_3D on the same array.
+ */
+template<class ForwardIt, class T, class U>
+bool linialsaks_search(ForwardIt first, ForwardIt last, const T& value, const BloomFilter<U>& bf){
+    return bf.may_contain(value) && linialsaks_search(first, last, value);
+}
+
+/*!
+ * \brief MAHL_e function that consults a Bloom filter first.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ * \param bf filter built with build_3D on the same array.
+ */
+template<class ForwardIt, class T, class U>
+bool MAHL_e(ForwardIt first, ForwardIt last, const T& value, const BloomFilter<U>& bf){
+    return bf.may_contain(value) && MAHL_e(first, last, value);
+}
+
+#endif
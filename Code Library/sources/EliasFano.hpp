@@ -0,0 +1,233 @@
+/** \file EliasFano.hpp
+ * Elias-Fano encoding of monotone sequences with native successor search.
+ */
+
+/*
+ *  EliasFano.hpp
+ *
+ *  Instituto de Informatica - UFG
+ *
+ */
+
+/*
+ * A non-decreasing sequence x_0 <= ... <= x_{n-1} of integers in [base, base+U] is stored in two parts:
+ *  - the l = floor(log2(U/n)) low bits of every x_i - base, packed;
+ *  - the high bits, in unary: bit (x_i - base) >> l + i is set in a bit vector of n + (U >> l) + 1 bits.
+ * The total is about 2 + log2(U/n) bits per element. Sampled positions of every EF_SAMPLE-th one and zero
+ * give select1 (access) and select0 (successor search) in constant expected time.
+ */
+
+#ifndef EliasFano_hpp
+#define EliasFano_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "InstanceView.hpp"
+
+#define EF_SAMPLE 256 /* Distance, in ones or zeros, between select samples. */
+
+/*!
+ * \brief Elias-Fano encoded non-decreasing sequence of an integral type T.
+ *
+ * begin() and end() iterate over the decoded values, so the sequence can be passed to the one-dimensional
+ * searches; contains() and next_geq() search it natively.
+ */
+template<class T>
+class EliasFano{
+public:
+    struct Accessor{
+        const EliasFano* p;
+        Accessor(const EliasFano* p = 0) : p(p){}
+        T operator[](std::ptrdiff_t i) const{ return p->access(i); }
+    };
+    typedef IndexedIterator<Accessor> iterator;
+
+    EliasFano() : n(0), l(0), base(0), universe(0){}
+
+    /*!
+     * \brief Encodes a sorted range.
+     * \param first iterator to start of array.
+     * \param last iterator to end of array.
+     */
+    template<class ForwardIt>
+    EliasFano(ForwardIt first, ForwardIt last) : n(0), l(0), base(0), universe(0){
+        build(first, last);
+    }
+
+    /*!
+     * \brief Encodes a sorted range.
+     * \param first iterator to start of array.
+     * \param last iterator to end of array.
+     */
+    template<class ForwardIt>
+    void build(ForwardIt first, ForwardIt last){
+        n = last - first;
+        low.clear();
+        high.clear();
+        samples1.clear();
+        samples0.clear();
+        if(n == 0)
+            return;
+        base = first[0];
+        universe = (std::uint64_t)first[n-1] - (std::uint64_t)base;
+        l = 0;
+        while(l < 63 && (universe / n) >> (l+1))
+            ++l;
+        std::uint64_t bits = n + (universe >> l) + 1;
+        high.assign((bits + 63) / 64, 0);
+        low.assign((n * l + 63) / 64 + 1, 0);
+        for( std::uint64_t i = 0; i < n; ++i){
+            std::uint64_t v = (std::uint64_t)first[i] - (std::uint64_t)base;
+            std::uint64_t h = (v >> l) + i;
+            high[h / 64] |= (std::uint64_t)1 << (h % 64);
+            set_low(i, v);
+        }
+        /* Select samples. */
+        std::uint64_t ones = 0, zeros = 0;
+        for( std::uint64_t p = 0; p < bits; ++p){
+            if((high[p / 64] >> (p % 64)) & 1){
+                if(ones % EF_SAMPLE == 0)
+                    samples1.push_back(p);
+                ++ones;
+            }else{
+                if(zeros % EF_SAMPLE == 0)
+                    samples0.push_back(p);
+                ++zeros;
+            }
+        }
+    }
+
+    /*!
+     * \brief Value at position i.
+     */
+    T access(std::uint64_t i) const{
+        std::uint64_t h = select1(i) - i;
+        return (T)((std::uint64_t)base + ((h << l) | get_low(i)));
+    }
+
+    T operator[](std::ptrdiff_t i) const{ return access(i); }
+
+    /*!
+     * \brief Position of the first element not less than value, or size() if there is none.
+     * \param  value is the search key.
+     */
+    std::uint64_t next_geq(const T& value) const{
+        if(n == 0 || value <= base)
+            return 0;
+        std::uint64_t v = (std::uint64_t)value - (std::uint64_t)base;
+        if(v > universe)
+            return n;
+        std::uint64_t h = v >> l;
+        /* Bucket h starts right after the h-th zero of the high bits. */
+        std::uint64_t p = h == 0? 0 : select0(h-1) + 1;
+        std::uint64_t i = p - h;
+        std::uint64_t w = p / 64;
+        std::uint64_t word = high[w] & (~(std::uint64_t)0 << (p % 64));
+        for( ; ; ){
+            while(word == 0)
+                word = high[++w];
+            std::uint64_t q = w*64 + __builtin_ctzll(word);
+            std::uint64_t x = ((q - i) << l) | get_low(i);
+            if(x >= v)
+                return i;
+            ++i;
+            word &= word - 1;
+        }
+    }
+
+    /*!
+     * \brief Membership test.
+     * \param  value is the search key.
+     */
+    bool contains(const T& value) const{
+        std::uint64_t i = next_geq(value);
+        return i < n && access(i) == value;
+    }
+
+    std::uint64_t size() const{ return n; }
+    iterator begin() const{ return iterator(Accessor(this), 0); }
+    iterator end() const{ return iterator(Accessor(this), n); }
+
+    /*!
+     * \brief Bytes used by the encoding, including the select samples.
+     */
+    std::size_t memory() const{
+        return (low.size() + high.size() + samples1.size() + samples0.size()) * sizeof(std::uint64_t);
+    }
+
+    /*!
+     * \brief Bits per element used by the encoding.
+     */
+    double bits_per_element() const{
+        return n? 8.0 * memory() / n : 0;
+    }
+
+private:
+    void set_low(std::uint64_t i, std::uint64_t v){
+        if(l == 0)
+            return;
+        v &= ((std::uint64_t)1 << l) - 1;
+        std::uint64_t pos = i * l;
+        low[pos / 64] |= v << (pos % 64);
+        if(pos % 64 + l > 64)
+            low[pos / 64 + 1] |= v >> (64 - pos % 64);
+    }
+
+    std::uint64_t get_low(std::uint64_t i) const{
+        if(l == 0)
+            return 0;
+        std::uint64_t pos = i * l;
+        std::uint64_t v = low[pos / 64] >> (pos % 64);
+        if(pos % 64 + l > 64)
+            v |= low[pos / 64 + 1] << (64 - pos % 64);
+        return v & (((std::uint64_t)1 << l) - 1);
+    }
+
+    /* Position of the r-th set bit of a word. */
+    static std::uint64_t select_in_word(std::uint64_t word, std::uint64_t r){
+        for( ; r > 0; --r)
+            word &= word - 1;
+        return __builtin_ctzll(word);
+    }
+
+    /* Position of the i-th one of the high bits. */
+    std::uint64_t select1(std::uint64_t i) const{
+        std::uint64_t p = samples1[i / EF_SAMPLE], r = i % EF_SAMPLE;
+        std::uint64_t w = p / 64;
+        std::uint64_t word = high[w] & (~(std::uint64_t)0 << (p % 64));
+        for( ; ; ){
+            std::uint64_t c = __builtin_popcountll(word);
+            if(r < c)
+                return w*64 + select_in_word(word, r);
+            r -= c;
+            word = high[++w];
+        }
+    }
+
+    /* Position of the i-th zero of the high bits. */
+    std::uint64_t select0(std::uint64_t i) const{
+        std::uint64_t p = samples0[i / EF_SAMPLE], r = i % EF_SAMPLE;
+        std::uint64_t w = p / 64;
+        std::uint64_t word = ~high[w] & (~(std::uint64_t)0 << (p % 64));
+        for( ; ; ){
+            std::uint64_t c = __builtin_popcountll(word);
+            if(r < c)
+                return w*64 + select_in_word(word, r);
+            r -= c;
+            word = ~high[++w];
+        }
+    }
+
+    std::uint64_t n;
+    unsigned l;
+    T base;
+    std::uint64_t universe;
+    std::vector<std::uint64_t> low;
+    std::vector<std::uint64_t> high;
+    std::vector<std::uint64_t> samples1;
+    std::vector<std::uint64_t> samples0;
+};
+
+#endif
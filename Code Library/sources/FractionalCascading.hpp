@@ -0,0 +1,218 @@
+/** \file FractionalCascading.hpp
+ * Fractional cascading structure for row-by-row searches in two-dimensional sorted arrays.
+ */
+
+/*
+ *  FractionalCascading.hpp
+ *
+ *  Instituto de Informatica - UFG
+ *
+ */
+
+#ifndef FractionalCascading_hpp
+#define FractionalCascading_hpp
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "SearchAlgorithms.hpp"
+
+/*!
+ * \brief Fractional cascading catalog built once over the rows of a two-dimensional array.
+ *
+ * Level i stores the row i merged with every other element of level i+1. Each entry keeps
+ * the lower bound position of its key in row i (own) and in level i+1 (down), so once the
+ * position in the first row is known, the position in every following row is obtained in O(1).
+ * A column of row lookups then costs O(log n + m) instead of O(m log n).
+ * Positions are stored as Pos, which must hold the length of the longest level.
+ */
+template<class T, class Pos = int>
+class FractionalCascade{
+public:
+    FractionalCascade(){}
+
+    /*!
+     * \brief Builds the catalog.
+     * \param first iterator to start of array.
+     * \param last iterator to end of array.
+     */
+    template<class ForwardIt>
+    FractionalCascade(ForwardIt first, ForwardIt last){
+        build(first, last);
+    }
+
+    /*!
+     * \brief Builds the catalog.
+     * \param first iterator to start of array.
+     * \param last iterator to end of array.
+     */
+    template<class ForwardIt>
+    void build(ForwardIt first, ForwardIt last){
+        std::ptrdiff_t m = last - first;
+        keys.assign(m, std::vector<T>());
+        own.assign(m, std::vector<Pos>());
+        down.assign(m, std::vector<Pos>());
+        for( std::ptrdiff_t i = m-1; i >= 0; --i){
+            std::ptrdiff_t n = first[i].size();
+            std::vector<T>& level = keys[i];
+            level.clear();
+            if(i == m-1){
+                level.assign(first[i].begin(), first[i].end());
+            }else{
+                /* Merge row i with every other element of level i+1. */
+                const std::vector<T>& next = keys[i+1];
+                std::ptrdiff_t a = 0, b = 1;
+                level.reserve(n + next.size()/2);
+                while(a < n || b < (std::ptrdiff_t)next.size()){
+                    if(b >= (std::ptrdiff_t)next.size() || (a < n && first[i][a] <= next[b]))
+                        level.push_back(first[i][a++]);
+                    else{
+                        level.push_back(next[b]);
+                        b += 2;
+                    }
+                }
+            }
+            /* Lower bound bridges, plus a sentinel entry for keys greater than every element. */
+            std::ptrdiff_t size = level.size();
+            own[i].resize(size+1);
+            down[i].resize(size+1);
+            std::ptrdiff_t p = 0, q = 0;
+            for( std::ptrdiff_t e = 0; e < size; ++e){
+                while(p < n && first[i][p] < level[e])
+                    ++p;
+                own[i][e] = p;
+                if(i < m-1){
+                    while(q < (std::ptrdiff_t)keys[i+1].size() && keys[i+1][q] < level[e])
+                        ++q;
+                    down[i][e] = q;
+                }
+            }
+            own[i][size] = n;
+            down[i][size] = i < m-1 ? (Pos)keys[i+1].size() : 0;
+        }
+    }
+
+    /*!
+     * \brief Number of rows in the catalog.
+     */
+    std::ptrdiff_t rows() const{
+        return keys.size();
+    }
+
+    /*!
+     * \brief Calls visit(i, p) for every row i in [i1, in], where p is the lower bound position of value in row i.
+     *  The walk stops as soon as visit returns true.
+     * \param i1 first row.
+     * \param in last row.
+     * \param  value is the search key.
+     * \param visit function called for every row.
+     */
+    template<class Index, class Visit>
+    bool cascade(Index i1, Index in, const T& value, Visit visit) const{
+        if(i1 > in)
+            return false;
+        Index e = std::lower_bound(keys[i1].begin(), keys[i1].end(), value) - keys[i1].begin();
+        for( Index i = i1; ; ++i){
+            if(visit(i, (Index)own[i][e]))
+                return true;
+            if(i == in)
+                return false;
+            /* The bridge lands at most one element past the lower bound of the next level. */
+            Index d = down[i][e];
+            while(d > 0 && !(keys[i+1][d-1] < value))
+                --d;
+            e = d;
+        }
+    }
+
+private:
+    std::vector<std::vector<T> > keys; /* Augmented levels. */
+    std::vector<std::vector<Pos> > own; /* Lower bound in the original row. */
+    std::vector<std::vector<Pos> > down; /* Lower bound in the next level. */
+};
+
+
+/*!
+ * \brief Binary search function using a fractional cascading catalog for the row by row case.
+ * \param first iterator to start of array.
+ * \param i1 topmost i position of the array.
+ * \param  j1 leftmost j position of the array.
+ * \param in bottommost i position of the array.
+ * \param jn rightmost j position of the array.
+ * \param  value is the search key.
+ * \param fc catalog built over the same array.
+ */
+template<class ForwardIt, class Index, class T, class U, class Pos>
+bool binary_search(ForwardIt first, Index i1, Index j1, Index in, Index jn, const T& value, const FractionalCascade<U, Pos>& fc){
+    if(i1 > in || j1 > jn)
+        return false;
+    return fc.cascade(i1, in, value, [&](Index i, Index p){
+        p = std::max(p, j1);
+        return p <= jn && first[i][p] == value;
+    });
+}
+
+/*!
+ * \brief Binary search function using a fractional cascading catalog.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ * \param fc catalog built over the same array.
+ */
+template<class ForwardIt, class T, class U, class Pos>
+bool binary_search(ForwardIt first, ForwardIt last, const T& value, const FractionalCascade<U, Pos>& fc){
+    std::ptrdiff_t m = last - first, n = first[0].size();
+    return index_dispatch(std::max(m, n), [&](auto size){
+        typedef decltype(size) Index;
+        return binary_search(first, (Index)0, (Index)0, (Index)(m-1), (Index)(n-1), value, fc);
+    });
+}
+
+/*!
+ * \brief Shen search function whose short subarrays are solved with a fractional cascading catalog.
+ *
+ * A subarray with fewer than 4 rows is searched by cascading through its rows in O(log n + rows). A narrow
+ * one with many rows would cascade through every row, so it is left to binary_search along its columns.
+ * \param first iterator to start of array.
+ * \param  j1 leftmost j position of the array.
+ * \param jn rightmost j position of the array.
+ * \param  value is the search key.
+ * \param fc catalog built over the same array.
+ */
+template<class ForwardIt, class Index, class T, class U, class Pos>
+bool shen_search(ForwardIt first, Index i1, Index j1, Index in, Index jn, const T& value, const FractionalCascade<U, Pos>& fc){
+    if((in - i1+1) < 4)
+        return binary_search(first, i1, j1, in, jn, value, fc);
+    if((jn-j1+1) < 4)
+        return binary_search(first, i1, j1, in, jn, value);
+    Index i = (i1+in)>>1;
+    if(value == first[i][j1])
+        return true;
+    if( value < first[i][j1])
+        return shen_search(first, i1, j1, i-1, jn, value, fc);
+    if( value > first[i][jn])
+        return shen_search(first, i+1, j1, in, jn, value, fc);
+    Index j = std::lower_bound(first[i].begin() + j1, first[i].begin()+jn+1, value) - first[i].begin();
+    if( first[i][j] == value)
+        return true;
+    return shen_search(first, i+1, j1, in, j-1, value, fc) || shen_search(first, i1, j, i-1, jn, value, fc);
+}
+
+/*!
+ * \brief Shen search function using a fractional cascading catalog.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ * \param fc catalog built over the same array.
+ */
+template<class ForwardIt, class T, class U, class Pos>
+bool shen_search(ForwardIt first, ForwardIt last, const T& value, const FractionalCascade<U, Pos>& fc){
+    std::ptrdiff_t m = last - first, n = first[0].size();
+    return index_dispatch(std::max(m, n), [&](auto size){
+        typedef decltype(size) Index;
+        return shen_search(first, (Index)0, (Index)0, (Index)(m-1), (Index)(n-1), value, fc);
+    });
+}
+
+#endif
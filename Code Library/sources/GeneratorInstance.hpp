@@ -20,11 +20,19 @@
 #ifndef GeneratorInstance_hpp
 #define GeneratorInstance_hpp
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <random>
+#include <thread>
+#include <type_traits>
 #include <vector>
 #include <math.h>
 
+#include "InstanceFormat.hpp"
+
 /*!
  * \brief Function to generate an increasing uniform distribution.
  * \param first iterator to start of array.
@@ -38,9 +46,9 @@ void LinearIncreasingDistribution(ForwardIt first, ForwardIt last, const T& min_
     std::mt19937_64 gen(seed);
     std::uniform_real_distribution<> dis(0.0, 1.0); /* Uniform value generated between 0 and 1.*/
     T offset;
-    int N = (last - first); /* Array size.*/
+    std::int64_t N = (last - first); /* Array size.*/
     offset = (max_value - min_value+1.) /(T)N; /*The values are generated within this range and added to the previous element of the sequence.*/
-    for(int i = 0; i < N; ++i){
+    for( std::int64_t i = 0; i < N; ++i){
         if(i == 0)
             first[i] = (T)(offset * std::sqrt(dis(gen))) + min_value;
         else
@@ -60,9 +68,9 @@ void LinearDecreasingDistribution(ForwardIt first, ForwardIt last, const T& min_
     std::mt19937_64 gen(seed);
     std::uniform_real_distribution<> dis(0.0, 1.0); /* Uniform value generated between 0 and 1.*/
     T offset;
-    int N = (last - first); /* Array size.*/
+    std::int64_t N = (last - first); /* Array size.*/
     offset = (max_value - min_value+1.)  / (T)N; /*The values are generated within this range and added to the previous element of the sequence.*/
-    for( int i = 0; i < N; ++i){
+    for( std::int64_t i = 0; i < N; ++i){
         if( i == 0)
             first[i] = (T)((offset) * (1. - std::sqrt(1.-dis(gen)))) + min_value;
         else
@@ -82,9 +90,9 @@ void LinearNormalDistribution(ForwardIt first, ForwardIt last, const T& min_valu
     std::mt19937_64 gen(seed);
     std::uniform_real_distribution<> dis(0.0, 1.0); /* Uniform value generated between 0 and 1.*/
     T offset;
-    int N = (last - first); /* Array size.*/
+    std::int64_t N = (last - first); /* Array size.*/
     offset = (max_value - min_value+1.)  / (T)N; /*The values are generated within this range and added to the previous element of the sequence.*/
-    for( int i = 0; i < N; ++i){
+    for( std::int64_t i = 0; i < N; ++i){
         if(i == 0)
             first[i] = (T)((offset) * dis(gen)) + min_value;
         else
@@ -93,6 +101,92 @@ void LinearNormalDistribution(ForwardIt first, ForwardIt last, const T& min_valu
 }
 
 
+//! Sorted fill kernels shared by the two- and three-dimensional generators.
+
+/*!
+ * \brief Fills the block [i0, i1) x [j0, j1) of a two-dimensional array in row-major order. Every element is
+ *  its increment plus the largest of its predecessors (min_value for the first element). The predecessors
+ *  outside the block must already be filled.
+ * \param first iterator to start of array.
+ * \param i0 first row of the block.
+ * \param i1 end of the rows of the block.
+ * \param j0 first column of the block.
+ * \param j1 end of the columns of the block.
+ * \param  min_value initial value of sequence.
+ * \param draw function returning the increment of element (i, j).
+ */
+template<class ForwardIt, class T, class Draw>
+void SortedFill_2D(ForwardIt first, int i0, int i1, int j0, int j1, const T& min_value, Draw draw){
+    for( int i = i0; i < i1; ++i){
+        int j = j0;
+        /* Boundary column. */
+        if(j == 0 && j < j1){
+            first[i][0] = draw(i, 0) + (i == 0? min_value : first[i-1][0]);
+            ++j;
+        }
+        /* Boundary row and interior. */
+        if(i == 0){
+            for( ; j < j1; ++j)
+                first[0][j] = draw(0, j) + first[0][j-1];
+        }else{
+            for( ; j < j1; ++j)
+                first[i][j] = draw(i, j) + std::max(first[i-1][j], first[i][j-1]);
+        }
+    }
+}
+
+/*!
+ * \brief Fills the block [i0, i1) x [j0, j1) x [k0, k1) of a three-dimensional array in row-major order. Every
+ *  element is its increment plus the largest of its predecessors (min_value for the first element). The
+ *  predecessors outside the block must already be filled.
+ * \param first iterator to start of array.
+ * \param i0 first i position of the block.
+ * \param i1 end of the i positions of the block.
+ * \param j0 first j position of the block.
+ * \param j1 end of the j positions of the block.
+ * \param k0 first k position of the block.
+ * \param k1 end of the k positions of the block.
+ * \param  min_value initial value of sequence.
+ * \param draw function returning the increment of element (i, j, k).
+ */
+template<class ForwardIt, class T, class Draw>
+void SortedFill_3D(ForwardIt first, int i0, int i1, int j0, int j1, int k0, int k1, const T& min_value, Draw draw){
+    for( int i = i0; i < i1; ++i){
+        for( int j = j0; j < j1; ++j){
+            int k = k0;
+            /* Boundary plane k = 0. */
+            if(k == 0 && k < k1){
+                T base;
+                if(i == 0 && j == 0)
+                    base = min_value;
+                else if(i == 0)
+                    base = first[0][j-1][0];
+                else if(j == 0)
+                    base = first[i-1][0][0];
+                else
+                    base = std::max(first[i-1][j][0], first[i][j-1][0]);
+                first[i][j][0] = draw(i, j, 0) + base;
+                ++k;
+            }
+            /* Boundary planes i = 0 and j = 0, then the interior. */
+            if(i > 0 && j > 0){
+                for( ; k < k1; ++k)
+                    first[i][j][k] = draw(i, j, k) + std::max(first[i-1][j][k], std::max(first[i][j-1][k], first[i][j][k-1]));
+            }else if(i > 0){
+                for( ; k < k1; ++k)
+                    first[i][j][k] = draw(i, j, k) + std::max(first[i-1][j][k], first[i][j][k-1]);
+            }else if(j > 0){
+                for( ; k < k1; ++k)
+                    first[i][j][k] = draw(i, j, k) + std::max(first[i][j-1][k], first[i][j][k-1]);
+            }else{
+                for( ; k < k1; ++k)
+                    first[i][j][k] = draw(i, j, k) + first[i][j][k-1];
+            }
+        }
+    }
+}
+
+
 //! Functions for generating a uniform distribution for a two-dimensional array.
 
 /*!
@@ -111,19 +205,9 @@ void LinearIncreasingDistribution_2D(ForwardIt first, ForwardIt last, const T& m
     int M = (last - first);  /* Size of the first dimension.*/
     int N = (first[0].size()); /* Size of the second dimension.*/
     offset = (max_value - min_value+1.) /(T)(M+N); /*The values are generated within this range and added to the previous element of the sequence.*/
-    for(int i = 0; i < M; ++i){
-        for(int j = 0; j < N; ++j){
-            if( i == 0 || j == 0){
-                if( i == 0 && j == 0)
-                    first[i][j] = (T)(offset * std::sqrt(dis(gen))) + min_value;
-                else if( i == 0)
-                    first[i][j] = (T)(offset * std::sqrt(dis(gen))) + first[i][j-1];
-                else
-                    first[i][j] = (T)(offset * std::sqrt(dis(gen))) + first[i-1][j];
-            }else
-                first[i][j] = (T)(offset * std::sqrt(dis(gen))) + std::max(first[i-1][j], first[i][j-1]);
-        }
-    }
+    SortedFill_2D(first, 0, M, 0, N, min_value, [&](int, int){
+        return (T)(offset * std::sqrt(dis(gen)));
+    });
 }
 /*!
  * \brief Function to generate a decreasing uniform distribution for a two-dimensional array.
@@ -141,19 +225,9 @@ void LinearDecreasingDistribution_2D(ForwardIt first, ForwardIt last, const T& m
     int M = (last - first); /* Size of the first dimension.*/
     int N = (first[0].size()); /* Size of the second dimension.*/
     offset = (max_value - min_value+1.)  / (T)(M+N); /*The values are generated within this range and added to the previous element of the sequence.*/
-    for( int i = 0; i < M; ++i){
-        for( int j=0; j < N; ++j){
-            if( i == 0 || j == 0){
-                if( i == 0 && j == 0)
-                    first[i][j] = (T)((offset)*(1. - std::sqrt(1.-dis(gen)))) + min_value;
-                else if( i == 0)
-                    first[i][j] = (T)((offset)*(1. - std::sqrt(1.-dis(gen)))) + first[i][j-1];
-                else
-                    first[i][j] = (T)((offset)*(1. - std::sqrt(1.-dis(gen)))) + first[i-1][j];
-            }else
-                first[i][j] = (T)((offset)*(1. - std::sqrt(1.-dis(gen)))) + std::max(first[i-1][j], first[i][j-1]);
-        }
-    }
+    SortedFill_2D(first, 0, M, 0, N, min_value, [&](int, int){
+        return (T)((offset)*(1. - std::sqrt(1.-dis(gen))));
+    });
 }
 
 /*!
@@ -172,19 +246,9 @@ void LinearNormalDistribution_2D(ForwardIt first, ForwardIt last, const T& min_v
     int M = (last - first); /* Size of the first dimension.*/
     int N = (first[0].size()); /* Size of the second dimension.*/
     offset = (max_value - min_value+1.) / (T)(M+N); /*The values are generated within this range and added to the previous element of the sequence.*/
-    for( int i = 0; i < M; ++i){
-        for( int j = 0; j < N; ++j){
-            if( i == 0 || j == 0){
-                if( i == 0 && j == 0)
-                    first[i][j] = (T)(offset * dis(gen)) + min_value;
-                else if( i == 0)
-                    first[i][j] = (T)(offset * dis(gen)) + first[i][j-1];
-                else
-                    first[i][j] = (T)(offset * dis(gen)) + first[i-1][j];
-            }else
-                first[i][j] = (T)(offset * dis(gen)) + std::max(first[i-1][j], first[i][j-1]);
-        }
-    }
+    SortedFill_2D(first, 0, M, 0, N, min_value, [&](int, int){
+        return (T)(offset * dis(gen));
+    });
 }
 
 
@@ -207,40 +271,9 @@ void LinearIncreasingDistribution_3D(ForwardIt first, ForwardIt last, const T& m
     int N = (first[0].size()); /* Size of the second dimension.*/
     int P =  (first[0][0].size()); /* Size of the third dimension.*/
     offset = (max_value - min_value+1.) /(T)(M+N+P); /*The values are generated within this range and added to the previous element of the sequence.*/
-    for( int i = 0; i < M; ++i){
-        for( int j = 0; j < N; ++j){
-            for( int k = 0; k < P; ++k){
-                if( i == 0 || j == 0 || k==0){
-                    if( i == 0 && j == 0 && k==0)
-                        first[i][j][k] = (T)(offset * std::sqrt(dis(gen))) + min_value;
-                    else if( i == 0){
-                        if( k == 0)
-                            first[i][j][k] = (T)(offset * std::sqrt(dis(gen))) + first[i][j-1][k];
-                        else if(j==0)
-                            first[i][j][k] = (T)(offset * std::sqrt(dis(gen))) + first[i][j][k-1];
-                        else
-                            first[i][j][k] = (T)(offset * std::sqrt(dis(gen))) + std::max(first[i][j-1][k], first[i][j][k-1]);
-                    }
-                    else if(j == 0){
-                        if( i == 0)
-                            first[i][j][k] = (T)(offset * std::sqrt(dis(gen))) + first[i][j][k-1];
-                        else if(k==0)
-                            first[i][j][k] = (T)(offset * std::sqrt(dis(gen))) + first[i-1][j][k];
-                        else
-                            first[i][j][k] = (T)(offset * std::sqrt(dis(gen))) + std::max(first[i-1][j][k], first[i][j][k-1]);
-                    }else{
-                        if( i == 0)
-                            first[i][j][k] = (T)(offset * std::sqrt(dis(gen))) + first[i][j-1][k];
-                        else if(j==0)
-                            first[i][j][k] = (T)(offset * std::sqrt(dis(gen))) + first[i-1][j][k];
-                        else
-                            first[i][j][k] = (T)(offset * std::sqrt(dis(gen))) + std::max(first[i-1][j][k], first[i][j-1][k]);
-                    }
-                }else
-                    first[i][j][k] = (T)(offset * std::sqrt(dis(gen))) + std::max(first[i-1][j][k], std::max(first[i][j-1][k], first[i][j][k-1]));
-            }
-        }
-    }
+    SortedFill_3D(first, 0, M, 0, N, 0, P, min_value, [&](int, int, int){
+        return (T)(offset * std::sqrt(dis(gen)));
+    });
 }
 
 /*!
@@ -260,40 +293,9 @@ void LinearDecreasingDistribution_3D(ForwardIt first, ForwardIt last, const T& m
     int N = (first[0].size()); /* Size of the second dimension.*/
     int P =  (first[0][0].size()); /* Size of the third dimension.*/
     offset = (max_value - min_value+1.)  / (T)(M+N+P); /*The values are generated within this range and added to the previous element of the sequence.*/
-    for( int i = 0; i < M; ++i){
-        for( int j = 0; j < N; ++j){
-            for( int k = 0; k < P; ++k){
-                if( i == 0 || j == 0 || k==0){
-                    if( i == 0 && j == 0 && k==0)
-                        first[i][j][k] = (T)(offset * (1.-std::sqrt(1.-dis(gen)))) + min_value;
-                    else if( i == 0){
-                        if( k == 0)
-                            first[i][j][k] = (T)(offset * (1.-std::sqrt(1.-dis(gen)))) + first[i][j-1][k];
-                        else if(j==0)
-                            first[i][j][k] = (T)(offset * (1.-std::sqrt(1.-dis(gen)))) + first[i][j][k-1];
-                        else
-                            first[i][j][k] = (T)(offset * (1.-std::sqrt(1.-dis(gen)))) + std::max(first[i][j-1][k], first[i][j][k-1]);
-                    }
-                    else if(j == 0){
-                        if( i == 0)
-                            first[i][j][k] = (T)(offset * (1.-std::sqrt(1.-dis(gen)))) + first[i][j][k-1];
-                        else if(k==0)
-                            first[i][j][k] = (T)(offset * (1.-std::sqrt(1.-dis(gen)))) + first[i-1][j][k];
-                        else
-                            first[i][j][k] = (T)(offset * (1.-std::sqrt(1.-dis(gen)))) + std::max(first[i-1][j][k], first[i][j][k-1]);
-                    }else{
-                        if( i == 0)
-                            first[i][j][k] = (T)(offset * (1.-std::sqrt(1.-dis(gen)))) + first[i][j-1][k];
-                        else if(j==0)
-                            first[i][j][k] = (T)(offset * (1.-std::sqrt(1.-dis(gen)))) + first[i-1][j][k];
-                        else
-                            first[i][j][k] = (T)(offset * (1.-std::sqrt(1.-dis(gen)))) + std::max(first[i-1][j][k], first[i][j-1][k]);
-                    }
-                }else
-                    first[i][j][k] = (T)(offset * (1.-std::sqrt(1.-dis(gen)))) + std::max(first[i-1][j][k], std::max(first[i][j-1][k], first[i][j][k-1]));
-            }
-        }
-    }
+    SortedFill_3D(first, 0, M, 0, N, 0, P, min_value, [&](int, int, int){
+        return (T)(offset * (1.-std::sqrt(1.-dis(gen))));
+    });
 }
 
 /*!
@@ -313,40 +315,500 @@ void LinearNormalDistribution_3D(ForwardIt first, ForwardIt last, const T& min_v
     int N = (first[0].size()); /* Size of the second dimension.*/
     int P =  (first[0][0].size()); /* Size of the third dimension.*/
     offset = (max_value - min_value+1.) / (T)(M+N+P); /*The values are generated within this range and added to the previous element of the sequence.*/
-    for( int i = 0; i < M; ++i){
+    SortedFill_3D(first, 0, M, 0, N, 0, P, min_value, [&](int, int, int){
+        return (T)(offset * dis(gen));
+    });
+}
+
+
+//! Counter-based parallel generation.
+
+/*
+ * The parallel generators draw the increment of element i from a counter-based generator keyed by the seed,
+ * so every value depends only on (seed, i) and not on the order the elements are generated in. Given the same
+ * seed, the output is bit-identical for any number of threads.
+ */
+
+/*! Distribution of the increments, with the same codes used by Main.cpp. */
+enum Distribution{
+    LID = 1, /* Linear increasing distribution. */
+    LDD = 2, /* Linear decreasing distribution. */
+    LND = 3  /* Linear normal distribution. */
+};
+
+/*!
+ * \brief Philox4x32-10 counter-based random number generator (Salmon et al., SC'11).
+ * \param ctr counter, replaced by the four random words.
+ * \param key 64-bit key.
+ */
+inline void Philox4x32(std::uint32_t ctr[4], std::uint64_t key){
+    std::uint32_t k0 = (std::uint32_t)key, k1 = (std::uint32_t)(key >> 32);
+    for( int r = 0; r < 10; ++r){
+        std::uint64_t p0 = (std::uint64_t)0xD2511F53u * ctr[0];
+        std::uint64_t p1 = (std::uint64_t)0xCD9E8D57u * ctr[2];
+        std::uint32_t c0 = (std::uint32_t)(p1 >> 32) ^ ctr[1] ^ k0;
+        std::uint32_t c2 = (std::uint32_t)(p0 >> 32) ^ ctr[3] ^ k1;
+        ctr[1] = (std::uint32_t)p1;
+        ctr[3] = (std::uint32_t)p0;
+        ctr[0] = c0;
+        ctr[2] = c2;
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+}
+
+/*!
+ * \brief Uniform value in [0, 1) for a counter of a stream.
+ * \param seed generator key.
+ * \param counter position in the stream.
+ * \param stream independent stream number.
+ */
+inline double CounterUniform(std::uint64_t seed, std::uint64_t counter, std::uint32_t stream = 0){
+    std::uint32_t c[4] = {(std::uint32_t)counter, (std::uint32_t)(counter >> 32), stream, 0};
+    Philox4x32(c, seed);
+    std::uint64_t bits = ((std::uint64_t)c[0] << 32) | c[1];
+    return (bits >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*!
+ * \brief Increment of a distribution for the uniform value u, as in the sequential generators.
+ * \param dist distribution.
+ * \param offset maximum increment.
+ * \param u uniform value in [0, 1).
+ */
+inline double DistributionIncrement(int dist, double offset, double u){
+    if(dist == LID)
+        return offset * std::sqrt(u);
+    if(dist == LDD)
+        return offset * (1. - std::sqrt(1.-u));
+    return offset * u;
+}
+
+/*!
+ * \brief Number of threads to use: the requested number, or one per hardware thread if 0.
+ */
+inline unsigned GeneratorThreads(unsigned threads){
+    if(threads == 0)
+        threads = std::thread::hardware_concurrency();
+    return threads == 0? 1 : threads;
+}
+
+/*!
+ * \brief Runs fn(b) for every b in [0, count) on a number of threads, handing out indexes dynamically.
+ * \param count number of work items.
+ * \param threads number of threads (0 for one per hardware thread).
+ * \param fn function called for every work item.
+ */
+template<class Function>
+void ParallelFor(std::int64_t count, unsigned threads, Function fn){
+    threads = (unsigned)std::min<std::int64_t>(GeneratorThreads(threads), std::max<std::int64_t>(count, 1));
+    std::atomic<std::int64_t> next(0);
+    auto work = [&](){
+        for( std::int64_t b = next++; b < count; b = next++)
+            fn(b);
+    };
+    std::vector<std::thread> pool;
+    for( unsigned t = 1; t < threads; ++t)
+        pool.emplace_back(work);
+    work();
+    for( std::size_t t = 0; t < pool.size(); ++t)
+        pool[t].join();
+}
+
+#define GENERATOR_BLOCK 65536 /* Elements per block of the parallel scan; fixed so the result does not depend on the thread count. */
+
+/*!
+ * \brief Function to generate a one-dimensional distribution in parallel.
+ *
+ * Every block of GENERATOR_BLOCK elements draws its increments independently (first into a buffer of uniform
+ * values, then through the distribution, so both loops vectorize), the block sums are scanned in order and
+ * every block is then rebuilt as a prefix sum starting from its block offset.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param dist distribution (LID, LDD or LND).
+ * \param  min_value initial value of sequence.
+ * \param max_value maximum sequence offset.
+ * \param seed random seed; equal seeds give equal arrays.
+ * \param threads number of threads (0 for one per hardware thread).
+ */
+template<class RandomIt, class T>
+void LinearDistribution_Parallel(RandomIt first, RandomIt last, int dist, const T& min_value, const T& max_value, std::uint64_t seed, unsigned threads = 0){
+    std::int64_t N = (last - first); /* Array size.*/
+    if(N <= 0)
+        return;
+    T offset = (max_value - min_value+1.) /(T)N; /*The values are generated within this range and added to the previous element of the sequence.*/
+    std::int64_t blocks = (N + GENERATOR_BLOCK - 1) / GENERATOR_BLOCK;
+    std::vector<T> sums(blocks);
+
+    /* Increments and block sums. */
+    ParallelFor(blocks, threads, [&](std::int64_t b){
+        std::int64_t lo = b * GENERATOR_BLOCK, hi = std::min<std::int64_t>(lo + GENERATOR_BLOCK, N);
+        std::vector<double> u(hi - lo);
+        for( std::int64_t i = lo; i < hi; ++i)
+            u[i-lo] = CounterUniform(seed, i);
+        T sum = 0;
+        for( std::int64_t i = lo; i < hi; ++i){
+            T inc = (T)DistributionIncrement(dist, offset, u[i-lo]);
+            first[i] = inc;
+            sum += inc;
+        }
+        sums[b] = sum;
+    });
+
+    /* Exclusive scan of the block sums, always in block order. */
+    T running = min_value;
+    for( std::int64_t b = 0; b < blocks; ++b){
+        T s = sums[b];
+        sums[b] = running;
+        running += s;
+    }
+
+    /* Prefix sum inside every block. */
+    ParallelFor(blocks, threads, [&](std::int64_t b){
+        std::int64_t lo = b * GENERATOR_BLOCK, hi = std::min<std::int64_t>(lo + GENERATOR_BLOCK, N);
+        T value = sums[b];
+        for( std::int64_t i = lo; i < hi; ++i){
+            value = first[i] + value;
+            first[i] = value;
+        }
+    });
+}
+
+/*!
+ * \brief Function to generate an increasing uniform distribution in parallel.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  min_value initial value of sequence.
+ * \param max_value maximum sequence offset.
+ * \param seed random seed.
+ * \param threads number of threads (0 for one per hardware thread).
+ */
+template<class RandomIt, class T>
+void LinearIncreasingDistribution_Parallel(RandomIt first, RandomIt last, const T& min_value, const T& max_value, std::uint64_t seed, unsigned threads = 0){
+    LinearDistribution_Parallel(first, last, LID, min_value, max_value, seed, threads);
+}
+
+/*!
+ * \brief Function to generate a decreasing uniform distribution in parallel.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  min_value initial value of sequence.
+ * \param max_value maximum sequence offset.
+ * \param seed random seed.
+ * \param threads number of threads (0 for one per hardware thread).
+ */
+template<class RandomIt, class T>
+void LinearDecreasingDistribution_Parallel(RandomIt first, RandomIt last, const T& min_value, const T& max_value, std::uint64_t seed, unsigned threads = 0){
+    LinearDistribution_Parallel(first, last, LDD, min_value, max_value, seed, threads);
+}
+
+/*!
+ * \brief Function to generate a normal uniform distribution in parallel.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  min_value initial value of sequence.
+ * \param max_value maximum sequence offset.
+ * \param seed random seed.
+ * \param threads number of threads (0 for one per hardware thread).
+ */
+template<class RandomIt, class T>
+void LinearNormalDistribution_Parallel(RandomIt first, RandomIt last, const T& min_value, const T& max_value, std::uint64_t seed, unsigned threads = 0){
+    LinearDistribution_Parallel(first, last, LND, min_value, max_value, seed, threads);
+}
+
+
+#define GENERATOR_TILE_2D 256 /* Tile side of the two-dimensional wavefront. */
+#define GENERATOR_TILE_3D 32 /* Tile side of the three-dimensional wavefront. */
+
+/*!
+ * \brief Function to generate a two-dimensional distribution in parallel.
+ *
+ * Element (i, j) depends on (i-1, j) and (i, j-1), so the tiles on an anti-diagonal a + b = d are independent.
+ * The tiles of each anti-diagonal are filled in parallel, and the increment of every element is drawn from
+ * the counter-based generator at its row-major position, so the output does not depend on the thread count.
+ * \param first iterator to start of array.
+ * \param last iterator to end of matrix.
+ * \param dist distribution (LID, LDD or LND).
+ * \param  min_value initial value of sequence.
+ * \param max_value maximum sequence offset.
+ * \param seed random seed; equal seeds give equal arrays.
+ * \param threads number of threads (0 for one per hardware thread).
+ */
+template<class ForwardIt, class T>
+void LinearDistribution_2D_Parallel(ForwardIt first, ForwardIt last, int dist, const T& min_value, const T& max_value, std::uint64_t seed, unsigned threads = 0){
+    int M = (last - first); /* Size of the first dimension.*/
+    if(M == 0)
+        return;
+    int N = (first[0].size()); /* Size of the second dimension.*/
+    T offset = (max_value - min_value+1.) /(T)(M+N); /*The values are generated within this range and added to the previous element of the sequence.*/
+    auto draw = [&](int i, int j){
+        return (T)DistributionIncrement(dist, offset, CounterUniform(seed, (std::uint64_t)i*N + j));
+    };
+    int TM = (M + GENERATOR_TILE_2D - 1) / GENERATOR_TILE_2D;
+    int TN = (N + GENERATOR_TILE_2D - 1) / GENERATOR_TILE_2D;
+    for( int d = 0; d <= TM + TN - 2; ++d){
+        int a0 = std::max(0, d - TN + 1), a1 = std::min(d, TM - 1);
+        ParallelFor(a1 - a0 + 1, threads, [&](std::int64_t t){
+            int a = a0 + (int)t, b = d - a;
+            SortedFill_2D(first, a*GENERATOR_TILE_2D, std::min(M, (a+1)*GENERATOR_TILE_2D),
+                          b*GENERATOR_TILE_2D, std::min(N, (b+1)*GENERATOR_TILE_2D), min_value, draw);
+        });
+    }
+}
+
+/*!
+ * \brief Function to generate a three-dimensional distribution in parallel.
+ *
+ * The tiles on an anti-diagonal plane a + b + c = d are independent and are filled in parallel. The increment
+ * of every element is drawn from the counter-based generator at its row-major position, so the output does
+ * not depend on the thread count.
+ * \param first iterator to start of array.
+ * \param last iterator to end of matrix.
+ * \param dist distribution (LID, LDD or LND).
+ * \param  min_value initial value of sequence.
+ * \param max_value maximum sequence offset.
+ * \param seed random seed; equal seeds give equal arrays.
+ * \param threads number of threads (0 for one per hardware thread).
+ */
+template<class ForwardIt, class T>
+void LinearDistribution_3D_Parallel(ForwardIt first, ForwardIt last, int dist, const T& min_value, const T& max_value, std::uint64_t seed, unsigned threads = 0){
+    int M = (last - first); /* Size of the first dimension.*/
+    if(M == 0)
+        return;
+    int N = (first[0].size()); /* Size of the second dimension.*/
+    int P = N > 0? (first[0][0].size()) : 0; /* Size of the third dimension.*/
+    T offset = (max_value - min_value+1.) /(T)(M+N+P); /*The values are generated within this range and added to the previous element of the sequence.*/
+    auto draw = [&](int i, int j, int k){
+        return (T)DistributionIncrement(dist, offset, CounterUniform(seed, ((std::uint64_t)i*N + j)*P + k));
+    };
+    int TM = (M + GENERATOR_TILE_3D - 1) / GENERATOR_TILE_3D;
+    int TN = (N + GENERATOR_TILE_3D - 1) / GENERATOR_TILE_3D;
+    int TP = (P + GENERATOR_TILE_3D - 1) / GENERATOR_TILE_3D;
+    std::vector<int> tiles;
+    for( int d = 0; d <= TM + TN + TP - 3; ++d){
+        tiles.clear();
+        for( int a = std::max(0, d - TN - TP + 2); a <= std::min(d, TM - 1); ++a)
+            for( int b = std::max(0, d - a - TP + 1); b <= std::min(d - a, TN - 1); ++b)
+                tiles.push_back(a), tiles.push_back(b);
+        ParallelFor(tiles.size() / 2, threads, [&](std::int64_t t){
+            int a = tiles[2*t], b = tiles[2*t+1], c = d - a - b;
+            SortedFill_3D(first, a*GENERATOR_TILE_3D, std::min(M, (a+1)*GENERATOR_TILE_3D),
+                          b*GENERATOR_TILE_3D, std::min(N, (b+1)*GENERATOR_TILE_3D),
+                          c*GENERATOR_TILE_3D, std::min(P, (c+1)*GENERATOR_TILE_3D), min_value, draw);
+        });
+    }
+}
+
+/*!
+ * \brief Function to generate a growing uniform distribution for a two-dimensional array in parallel.
+ * \param first iterator to start of array.
+ * \param last iterator to end of matrix.
+ * \param  min_value initial value of sequence.
+ * \param max_value maximum sequence offset.
+ * \param seed random seed.
+ * \param threads number of threads (0 for one per hardware thread).
+ */
+template<class ForwardIt, class T>
+void LinearIncreasingDistribution_2D_Parallel(ForwardIt first, ForwardIt last, const T& min_value, const T& max_value, std::uint64_t seed, unsigned threads = 0){
+    LinearDistribution_2D_Parallel(first, last, LID, min_value, max_value, seed, threads);
+}
+
+/*!
+ * \brief Function to generate a decreasing uniform distribution for a two-dimensional array in parallel.
+ * \param first iterator to start of array.
+ * \param last iterator to end of matrix.
+ * \param  min_value initial value of sequence.
+ * \param max_value maximum sequence offset.
+ * \param seed random seed.
+ * \param threads number of threads (0 for one per hardware thread).
+ */
+template<class ForwardIt, class T>
+void LinearDecreasingDistribution_2D_Parallel(ForwardIt first, ForwardIt last, const T& min_value, const T& max_value, std::uint64_t seed, unsigned threads = 0){
+    LinearDistribution_2D_Parallel(first, last, LDD, min_value, max_value, seed, threads);
+}
+
+/*!
+ * \brief Function to generate a normal uniform distribution for a two-dimensional array in parallel.
+ * \param first iterator to start of array.
+ * \param last iterator to end of matrix.
+ * \param  min_value initial value of sequence.
+ * \param max_value maximum sequence offset.
+ * \param seed random seed.
+ * \param threads number of threads (0 for one per hardware thread).
+ */
+template<class ForwardIt, class T>
+void LinearNormalDistribution_2D_Parallel(ForwardIt first, ForwardIt last, const T& min_value, const T& max_value, std::uint64_t seed, unsigned threads = 0){
+    LinearDistribution_2D_Parallel(first, last, LND, min_value, max_value, seed, threads);
+}
+
+/*!
+ * \brief Function to generate a growing uniform distribution for a three-dimensional array in parallel.
+ * \param first iterator to start of array.
+ * \param last iterator to end of matrix.
+ * \param  min_value initial value of sequence.
+ * \param max_value maximum sequence offset.
+ * \param seed random seed.
+ * \param threads number of threads (0 for one per hardware thread).
+ */
+template<class ForwardIt, class T>
+void LinearIncreasingDistribution_3D_Parallel(ForwardIt first, ForwardIt last, const T& min_value, const T& max_value, std::uint64_t seed, unsigned threads = 0){
+    LinearDistribution_3D_Parallel(first, last, LID, min_value, max_value, seed, threads);
+}
+
+/*!
+ * \brief Function to generate a decreasing uniform distribution for a three-dimensional array in parallel.
+ * \param first iterator to start of array.
+ * \param last iterator to end of matrix.
+ * \param  min_value initial value of sequence.
+ * \param max_value maximum sequence offset.
+ * \param seed random seed.
+ * \param threads number of threads (0 for one per hardware thread).
+ */
+template<class ForwardIt, class T>
+void LinearDecreasingDistribution_3D_Parallel(ForwardIt first, ForwardIt last, const T& min_value, const T& max_value, std::uint64_t seed, unsigned threads = 0){
+    LinearDistribution_3D_Parallel(first, last, LDD, min_value, max_value, seed, threads);
+}
+
+/*!
+ * \brief Function to generate a normal uniform distribution for a three-dimensional array in parallel.
+ * \param first iterator to start of array.
+ * \param last iterator to end of matrix.
+ * \param  min_value initial value of sequence.
+ * \param max_value maximum sequence offset.
+ * \param seed random seed.
+ * \param threads number of threads (0 for one per hardware thread).
+ */
+template<class ForwardIt, class T>
+void LinearNormalDistribution_3D_Parallel(ForwardIt first, ForwardIt last, const T& min_value, const T& max_value, std::uint64_t seed, unsigned threads = 0){
+    LinearDistribution_3D_Parallel(first, last, LND, min_value, max_value, seed, threads);
+}
+
+
+//! Functions for writing instances to the binary format described in InstanceFormat.hpp.
+
+/*!
+ * \brief Writes the header and the padding up to the payload. The header is rewritten by WriteInstanceEnd.
+ * \param file output file.
+ * \param h header.
+ */
+inline bool WriteInstanceBegin(FILE* file, const InstanceHeader& h){
+    static const char zeros[INSTANCE_ALIGNMENT] = {0};
+    if(fwrite(&h, sizeof(h), 1, file) != 1)
+        return false;
+    return fwrite(zeros, 1, h.payload_offset - sizeof(h), file) == h.payload_offset - sizeof(h);
+}
+
+/*!
+ * \brief Rewrites the header with the final flags and closes the file.
+ * \param file output file.
+ * \param h header.
+ * \param ok whether every previous write succeeded.
+ */
+inline bool WriteInstanceEnd(FILE* file, const InstanceHeader& h, bool ok){
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(&h, sizeof(h), 1, file) == 1;
+    return fclose(file) == 0 && ok;
+}
+
+/*!
+ * \brief Function to write an array to an instance file.
+ * \param filename path of the output file.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \return true if the file was written.
+ */
+template<class ForwardIt>
+bool WriteInstance(const char* filename, ForwardIt first, ForwardIt last){
+    typedef typename std::decay<decltype(first[0])>::type T;
+    FILE* file = fopen(filename, "wb");
+    if(!file)
+        return false;
+    std::uint64_t ext[1] = {(std::uint64_t)(last - first)};
+    InstanceHeader h;
+    InitInstanceHeader<T>(h, 1, ext, INSTANCE_SORTED);
+    bool ok = WriteInstanceBegin(file, h);
+    /* Streamed in chunks of GENERATOR_BLOCK elements, so the buffer does not grow with the array. */
+    std::ptrdiff_t n = last - first;
+    std::vector<T> chunk((std::size_t)std::min<std::ptrdiff_t>(n, GENERATOR_BLOCK));
+    for( std::ptrdiff_t lo = 0; lo < n && ok; lo += GENERATOR_BLOCK){
+        std::size_t size = (std::size_t)std::min<std::ptrdiff_t>(GENERATOR_BLOCK, n - lo);
+        if(lo > 0 && first[lo] < chunk.back())
+            h.flags &= ~INSTANCE_SORTED;
+        for( std::size_t i = 0; i < size; ++i){
+            chunk[i] = first[lo + i];
+            if(i > 0 && chunk[i] < chunk[i-1])
+                h.flags &= ~INSTANCE_SORTED;
+        }
+        ok = fwrite(chunk.data(), sizeof(T), size, file) == size;
+    }
+    return WriteInstanceEnd(file, h, ok);
+}
+
+/*!
+ * \brief Function to write a two-dimensional array to an instance file.
+ * \param filename path of the output file.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \return true if the file was written.
+ */
+template<class ForwardIt>
+bool WriteInstance_2D(const char* filename, ForwardIt first, ForwardIt last){
+    typedef typename std::decay<decltype(first[0][0])>::type T;
+    FILE* file = fopen(filename, "wb");
+    if(!file)
+        return false;
+    int M = (last - first);
+    int N = M > 0? (first[0].size()) : 0;
+    std::uint64_t ext[2] = {(std::uint64_t)M, (std::uint64_t)N};
+    InstanceHeader h;
+    InitInstanceHeader<T>(h, 2, ext, INSTANCE_SORTED);
+    bool ok = WriteInstanceBegin(file, h);
+    std::vector<T> row(N), prev(N);
+    for( int i = 0; i < M && ok; ++i){
+        for( int j = 0; j < N; ++j){
+            row[j] = first[i][j];
+            if((j > 0 && row[j] < row[j-1]) || (i > 0 && row[j] < prev[j]))
+                h.flags &= ~INSTANCE_SORTED;
+        }
+        ok = fwrite(row.data(), sizeof(T), N, file) == (std::size_t)N;
+        row.swap(prev);
+    }
+    return WriteInstanceEnd(file, h, ok);
+}
+
+/*!
+ * \brief Function to write a three-dimensional array to an instance file.
+ * \param filename path of the output file.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \return true if the file was written.
+ */
+template<class ForwardIt>
+bool WriteInstance_3D(const char* filename, ForwardIt first, ForwardIt last){
+    typedef typename std::decay<decltype(first[0][0][0])>::type T;
+    FILE* file = fopen(filename, "wb");
+    if(!file)
+        return false;
+    int M = (last - first);
+    int N = M > 0? (first[0].size()) : 0;
+    int P = N > 0? (first[0][0].size()) : 0;
+    std::uint64_t ext[3] = {(std::uint64_t)M, (std::uint64_t)N, (std::uint64_t)P};
+    InstanceHeader h;
+    InitInstanceHeader<T>(h, 3, ext, INSTANCE_SORTED);
+    bool ok = WriteInstanceBegin(file, h);
+    std::vector<T> plane((std::size_t)N*P), prev((std::size_t)N*P);
+    for( int i = 0; i < M && ok; ++i){
         for( int j = 0; j < N; ++j){
             for( int k = 0; k < P; ++k){
-                if( i == 0 || j == 0 || k==0){
-                    if( i == 0 && j == 0 && k==0)
-                        first[i][j][k] = (T)(offset * dis(gen)) + min_value;
-                    else if( i == 0){
-                        if( k == 0)
-                            first[i][j][k] = (T)(offset * dis(gen)) + first[i][j-1][k];
-                        else if(j==0)
-                            first[i][j][k] = (T)(offset * dis(gen)) + first[i][j][k-1];
-                        else
-                            first[i][j][k] = (T)(offset * dis(gen)) + std::max(first[i][j-1][k], first[i][j][k-1]);
-                    }
-                    else if(j == 0){
-                        if( i == 0)
-                            first[i][j][k] = (T)(offset * dis(gen)) + first[i][j][k-1];
-                        else if(k==0)
-                            first[i][j][k] = (T)(offset * dis(gen)) + first[i-1][j][k];
-                        else
-                            first[i][j][k] = (T)(offset * dis(gen)) + std::max(first[i-1][j][k], first[i][j][k-1]);
-                    }else{
-                        if( i == 0)
-                            first[i][j][k] = (T)(offset * dis(gen)) + first[i][j-1][k];
-                        else if(j==0)
-                            first[i][j][k] = (T)(offset * dis(gen)) + first[i-1][j][k];
-                        else
-                            first[i][j][k] = (T)(offset * dis(gen)) + std::max(first[i-1][j][k], first[i][j-1][k]);
-                    }
-                }else
-                    first[i][j][k] = (T)(offset * dis(gen)) + std::max(first[i-1][j][k], std::max(first[i][j-1][k], first[i][j][k-1]));
+                std::size_t c = (std::size_t)j*P + k;
+                plane[c] = first[i][j][k];
+                if((k > 0 && plane[c] < plane[c-1]) || (j > 0 && plane[c] < plane[c-P]) || (i > 0 && plane[c] < prev[c]))
+                    h.flags &= ~INSTANCE_SORTED;
             }
         }
+        ok = fwrite(plane.data(), sizeof(T), plane.size(), file) == plane.size();
+        plane.swap(prev);
     }
+    return WriteInstanceEnd(file, h, ok);
 }
 
 #endif
\ No newline at end of file
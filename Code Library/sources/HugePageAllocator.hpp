@@ -0,0 +1,414 @@
+/** \file HugePageAllocator.hpp
+ * Huge-page and NUMA-aware memory for search instances.
+ */
+
+/*
+ *  HugePageAllocator.hpp
+ *
+ *  Instituto de Informatica - UFG
+ *
+ */
+
+/*
+ * Random probes (binary, interpolation, MAHL_e) touch a different 4K page almost every time, so large
+ * instances spend much of their time on TLB misses. huge_alloc maps memory with explicit huge pages
+ * (MAP_HUGETLB, 2M or 1G) when the system has them reserved; otherwise it maps memory aligned to 2M and
+ * asks for transparent huge pages with madvise(MADV_HUGEPAGE), and as a last resort uses normal pages.
+ *
+ * On NUMA machines the mapping can be interleaved page by page over every node, or bound to one node,
+ * with the mbind system call (called directly, so libnuma is not needed). The policy is set before the
+ * first touch, so it applies whatever thread fills the instance, e.g. the parallel generators.
+ *
+ * HugePageAllocator plugs this into standard containers, e.g. DenseArray<T, D, HugePageAllocator<T> >
+ * or std::vector<T, HugePageAllocator<T> >. Small requests go to operator new. page_stats() counts the
+ * bytes obtained with every kind of page, and page_report() prints the page sizes and the NUMA nodes
+ * that actually back a buffer.
+ */
+
+#ifndef HugePageAllocator_hpp
+#define HugePageAllocator_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "InstanceView.hpp"
+
+#define HUGE_PAGE_2M ((std::size_t)1 << 21)
+#define HUGE_PAGE_1G ((std::size_t)1 << 30)
+#define HUGE_ALLOC_MIN ((std::size_t)1 << 20) /* Smaller requests of HugePageAllocator go to operator new. */
+#define NUMA_MAX_NODES 64
+
+#ifndef MPOL_DEFAULT
+#define MPOL_DEFAULT 0
+#define MPOL_PREFERRED 1
+#define MPOL_BIND 2
+#define MPOL_INTERLEAVE 3
+#endif
+
+/*! Kind of pages requested or obtained. */
+enum PageKind{
+    PAGES_SMALL = 0, /* Normal pages. */
+    PAGES_THP = 1,   /* Transparent huge pages (madvise). */
+    PAGES_2M = 2,    /* Explicit 2M huge pages. */
+    PAGES_1G = 3     /* Explicit 1G huge pages. */
+};
+
+/*! Placement of the pages over the NUMA nodes. */
+enum NumaPlacement{
+    NUMA_LOCAL = 0,      /* Default policy: the node of the thread that touches the page first. */
+    NUMA_INTERLEAVE = 1, /* Round robin over every node. */
+    NUMA_NODE = 2        /* Bound to one node. */
+};
+
+/*!
+ * \brief How huge_alloc maps memory.
+ */
+struct PagePolicy{
+    PageKind pages;
+    NumaPlacement numa;
+    int node; /* Node for NUMA_NODE. */
+
+    PagePolicy(PageKind pages = PAGES_2M, NumaPlacement numa = NUMA_LOCAL, int node = 0) : pages(pages), numa(numa), node(node){}
+
+    bool operator==(const PagePolicy& o) const{ return pages == o.pages && numa == o.numa && node == o.node; }
+    bool operator!=(const PagePolicy& o) const{ return !(*this == o); }
+};
+
+/*!
+ * \brief Bytes currently mapped with every kind of page, and placement requests that failed.
+ */
+struct PageStats{
+    std::atomic<std::uint64_t> bytes[4]; /* Indexed by PageKind. */
+    std::atomic<std::uint64_t> fallbacks;      /* Requests served with smaller pages than asked for. */
+    std::atomic<std::uint64_t> numa_failures;  /* mbind calls that failed. */
+};
+
+inline PageStats& page_stats(){
+    static PageStats stats = {{{0}, {0}, {0}, {0}}, {0}, {0}};
+    return stats;
+}
+
+inline const char* PageKindName(PageKind k){
+    static const char* names[] = {"4K", "THP", "2M", "1G"};
+    return names[k];
+}
+
+/*!
+ * \brief Number of NUMA nodes of the machine (1 without NUMA support).
+ */
+inline int numa_nodes(){
+#ifdef __linux__
+    FILE* f = fopen("/sys/devices/system/node/online", "r");
+    if(!f)
+        return 1;
+    int nodes = 0, a, b;
+    char sep;
+    while(fscanf(f, "%d", &a) == 1){
+        b = a;
+        if(fscanf(f, "%c", &sep) == 1 && sep == '-'){
+            if(fscanf(f, "%d", &b) != 1)
+                break;
+            if(fscanf(f, "%c", &sep) != 1)
+                sep = '\n';
+        }
+        nodes = b + 1 > nodes? b + 1 : nodes;
+        if(sep != ',')
+            break;
+    }
+    fclose(f);
+    return nodes < 1? 1 : (nodes > NUMA_MAX_NODES? NUMA_MAX_NODES : nodes);
+#else
+    return 1;
+#endif
+}
+
+/*!
+ * \brief Applies a NUMA placement to a mapping that was not touched yet.
+ * \return true if the policy was set (always true for NUMA_LOCAL).
+ */
+inline bool numa_place(void* p, std::size_t bytes, NumaPlacement numa, int node){
+#ifdef __linux__
+    if(numa == NUMA_LOCAL)
+        return true;
+    int nodes = numa_nodes();
+    unsigned long mask = 0;
+    if(numa == NUMA_INTERLEAVE)
+        mask = nodes >= 64? ~0UL : ((1UL << nodes) - 1);
+    else
+        mask = 1UL << (node % nodes);
+    int mode = numa == NUMA_INTERLEAVE? MPOL_INTERLEAVE : MPOL_BIND;
+    if(syscall(SYS_mbind, p, bytes, mode, &mask, (unsigned long)NUMA_MAX_NODES + 1, 0UL) == 0)
+        return true;
+    ++page_stats().numa_failures;
+    return false;
+#else
+    (void)p; (void)bytes; (void)numa; (void)node;
+    return numa == NUMA_LOCAL;
+#endif
+}
+
+/*!
+ * \brief Size of the mapping that huge_alloc makes for a request of bytes with pages of a kind.
+ */
+inline std::size_t huge_mapping_size(std::size_t bytes, PageKind kind){
+    std::size_t page = kind == PAGES_1G? HUGE_PAGE_1G : (kind == PAGES_SMALL? 4096 : HUGE_PAGE_2M);
+    return (bytes + page - 1) / page * page;
+}
+
+/*!
+ * \brief Maps memory with the requested pages, falling back to smaller ones.
+ * \param bytes size of the buffer.
+ * \param policy page size and NUMA placement.
+ * \param got receives the kind of pages obtained; it must be passed back to huge_free.
+ * \return the buffer, aligned to its page size, or 0.
+ */
+inline void* huge_alloc(std::size_t bytes, const PagePolicy& policy, PageKind* got){
+    if(bytes == 0)
+        bytes = 1;
+#ifdef __linux__
+    void* p = MAP_FAILED;
+    PageKind kind = policy.pages;
+    /* Explicit huge pages, from the reserved pool. */
+    if(kind == PAGES_1G){
+        p = mmap(0, huge_mapping_size(bytes, PAGES_1G), PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (30 << MAP_HUGE_SHIFT), -1, 0);
+        if(p == MAP_FAILED)
+            kind = PAGES_2M;
+    }
+    if(p == MAP_FAILED && kind == PAGES_2M){
+        p = mmap(0, huge_mapping_size(bytes, PAGES_2M), PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (21 << MAP_HUGE_SHIFT), -1, 0);
+        if(p == MAP_FAILED)
+            kind = PAGES_THP;
+    }
+    /* Transparent huge pages: a 2M-aligned mapping, trimmed from a larger one. */
+    if(p == MAP_FAILED){
+        std::size_t size = huge_mapping_size(bytes, kind == PAGES_THP? PAGES_THP : PAGES_SMALL);
+        std::size_t extra = kind == PAGES_THP? HUGE_PAGE_2M : 0;
+        char* raw = (char*)mmap(0, size + extra, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(raw == (char*)MAP_FAILED)
+            return 0;
+        char* q = raw;
+        if(extra){
+            q = (char*)(((std::uintptr_t)raw + HUGE_PAGE_2M - 1) & ~(std::uintptr_t)(HUGE_PAGE_2M - 1));
+            if(q > raw)
+                munmap(raw, q - raw);
+            if(q + size < raw + size + extra)
+                munmap(q + size, raw + size + extra - (q + size));
+            if(madvise(q, size, MADV_HUGEPAGE) != 0){
+                /* No THP support: keep only the normal pages that were asked for. */
+                kind = PAGES_SMALL;
+                std::size_t small = huge_mapping_size(bytes, PAGES_SMALL);
+                if(small < size)
+                    munmap(q + small, size - small);
+            }
+        }
+        p = q;
+    }
+    if(kind != policy.pages)
+        ++page_stats().fallbacks;
+    numa_place(p, huge_mapping_size(bytes, kind), policy.numa, policy.node);
+    page_stats().bytes[kind] += huge_mapping_size(bytes, kind);
+    *got = kind;
+    return p;
+#else
+    (void)policy;
+    *got = PAGES_SMALL;
+    page_stats().bytes[PAGES_SMALL] += bytes;
+    return ::operator new(bytes, std::nothrow);
+#endif
+}
+
+/*!
+ * \brief Releases a buffer of huge_alloc.
+ * \param kind kind of pages returned by huge_alloc.
+ */
+inline void huge_free(void* p, std::size_t bytes, PageKind kind){
+    if(!p)
+        return;
+    if(bytes == 0)
+        bytes = 1;
+#ifdef __linux__
+    munmap(p, huge_mapping_size(bytes, kind));
+    page_stats().bytes[kind] -= huge_mapping_size(bytes, kind);
+#else
+    (void)kind;
+    page_stats().bytes[PAGES_SMALL] -= bytes;
+    ::operator delete(p);
+#endif
+}
+
+/*!
+ * \brief Page sizes and NUMA nodes backing a buffer.
+ */
+struct PagePlacement{
+    std::size_t huge_bytes;   /* Bytes backed by huge pages (explicit or transparent), from /proc/self/smaps. */
+    std::size_t sampled;      /* Pages sampled for the node counts. */
+    std::size_t absent;       /* Sampled pages not yet touched. */
+    std::vector<std::size_t> node_pages; /* Sampled pages on every node. */
+};
+
+/*!
+ * \brief Measures the placement of a buffer.
+ * \param p start of the buffer.
+ * \param bytes size of the buffer.
+ * \param samples maximum number of pages whose node is queried.
+ */
+inline PagePlacement page_placement(const void* p, std::size_t bytes, std::size_t samples = 4096){
+    PagePlacement r;
+    r.huge_bytes = r.sampled = r.absent = 0;
+    r.node_pages.assign(numa_nodes(), 0);
+#ifdef __linux__
+    /* Huge page bytes of the mappings that overlap the buffer. */
+    std::uintptr_t lo = (std::uintptr_t)p, hi = lo + bytes;
+    FILE* f = fopen("/proc/self/smaps", "r");
+    if(f){
+        char line[512];
+        bool inside = false;
+        std::size_t page_kb = 4;
+        while(fgets(line, sizeof(line), f)){
+            unsigned long a, b;
+            std::size_t kb;
+            if(sscanf(line, "%lx-%lx ", &a, &b) == 2 && std::strchr(line, '-') < std::strchr(line, ' ')){
+                inside = a < hi && lo < b;
+                page_kb = 4;
+            }
+            else if(inside && sscanf(line, "KernelPageSize: %zu kB", &kb) == 1)
+                page_kb = kb;
+            else if(inside && sscanf(line, "AnonHugePages: %zu kB", &kb) == 1)
+                r.huge_bytes += kb << 10;
+            else if(inside && page_kb > 4 && sscanf(line, "Rss: %zu kB", &kb) == 1)
+                r.huge_bytes += kb << 10;
+        }
+        fclose(f);
+    }
+    /* Node of a sample of the pages. */
+    std::size_t pages = (bytes + 4095) / 4096;
+    std::size_t step = pages > samples? pages / samples : 1;
+    std::vector<void*> addr;
+    for( std::size_t i = 0; i < pages && addr.size() < samples; i += step)
+        addr.push_back((char*)((std::uintptr_t)p & ~(std::uintptr_t)4095) + i*4096);
+    std::vector<int> status(addr.size(), -1);
+    if(!addr.empty() && syscall(SYS_move_pages, 0, (unsigned long)addr.size(), addr.data(), (const int*)0, status.data(), 0) == 0){
+        for( std::size_t i = 0; i < status.size(); ++i){
+            ++r.sampled;
+            if(status[i] >= 0 && status[i] < (int)r.node_pages.size())
+                ++r.node_pages[status[i]];
+            else
+                ++r.absent;
+        }
+    }
+#else
+    (void)p; (void)bytes; (void)samples;
+#endif
+    return r;
+}
+
+/*!
+ * \brief Prints the page statistics of the process and the placement of a buffer.
+ * \param out output file, e.g. stdout.
+ * \param p start of the buffer, or 0 for the process statistics only.
+ * \param bytes size of the buffer.
+ */
+inline void page_report(FILE* out, const void* p = 0, std::size_t bytes = 0){
+    PageStats& s = page_stats();
+    fprintf(out, "Pages: 1G %.1f MB, 2M %.1f MB, THP %.1f MB, 4K %.1f MB; fallbacks %llu, NUMA failures %llu; nodes %d\n",
+            s.bytes[PAGES_1G] / 1048576., s.bytes[PAGES_2M] / 1048576., s.bytes[PAGES_THP] / 1048576., s.bytes[PAGES_SMALL] / 1048576.,
+            (unsigned long long)s.fallbacks.load(), (unsigned long long)s.numa_failures.load(), numa_nodes());
+    if(!p)
+        return;
+    PagePlacement r = page_placement(p, bytes);
+    fprintf(out, "Buffer: %.1f MB, %.1f%% on huge pages; sampled pages per node:", bytes / 1048576.,
+            bytes? 100. * (r.huge_bytes < bytes? r.huge_bytes : bytes) / bytes : 0.);
+    for( std::size_t n = 0; n < r.node_pages.size(); ++n)
+        fprintf(out, " %zu", r.node_pages[n]);
+    fprintf(out, " (not touched %zu)\n", r.absent);
+}
+
+
+/*!
+ * \brief Kind of pages of the live buffers of HugePageAllocator, needed to unmap them.
+ */
+struct HugeBufferRegistry{
+    std::mutex mutex;
+    std::unordered_map<void*, PageKind> kinds;
+};
+
+inline HugeBufferRegistry& huge_buffers(){
+    static HugeBufferRegistry registry;
+    return registry;
+}
+
+/*!
+ * \brief Standard allocator that maps large buffers with huge_alloc.
+ */
+template<class T>
+class HugePageAllocator{
+public:
+    typedef T value_type;
+
+    HugePageAllocator(const PagePolicy& policy = PagePolicy()) : policy(policy){}
+
+    template<class U>
+    HugePageAllocator(const HugePageAllocator<U>& o) : policy(o.page_policy()){}
+
+    T* allocate(std::size_t n){
+        std::size_t bytes = n * sizeof(T);
+        if(bytes < HUGE_ALLOC_MIN)
+            return (T*)::operator new(bytes);
+        PageKind got;
+        void* p = huge_alloc(bytes, policy, &got);
+        if(!p)
+            throw std::bad_alloc();
+        HugeBufferRegistry& r = huge_buffers();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.kinds[p] = got;
+        return (T*)p;
+    }
+
+    void deallocate(T* p, std::size_t n){
+        std::size_t bytes = n * sizeof(T);
+        if(bytes < HUGE_ALLOC_MIN){
+            ::operator delete(p);
+            return;
+        }
+        PageKind kind;
+        {
+            HugeBufferRegistry& r = huge_buffers();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            std::unordered_map<void*, PageKind>::iterator it = r.kinds.find(p);
+            kind = it->second;
+            r.kinds.erase(it);
+        }
+        huge_free(p, bytes, kind);
+    }
+
+    const PagePolicy& page_policy() const{ return policy; }
+
+    bool operator==(const HugePageAllocator& o) const{ return policy == o.policy; }
+    bool operator!=(const HugePageAllocator& o) const{ return policy != o.policy; }
+
+private:
+    PagePolicy policy;
+};
+
+/*!
+ * \brief Dense row-major array on huge pages, e.g. HugeDenseArray<int, 3> a(extents, PagePolicy(PAGES_2M, NUMA_INTERLEAVE)).
+ */
+template<class T, std::size_t D>
+using HugeDenseArray = DenseArray<T, D, HugePageAllocator<T> >;
+
+#endif
@@ -0,0 +1,145 @@
+/** \file InstanceFormat.hpp
+ * Versioned binary file format for sorted instances.
+ */
+
+/*
+ *  InstanceFormat.hpp
+ *
+ *  Instituto de Informatica - UFG
+ *
+ */
+
+/*
+ * Layout of an instance file:
+ *
+ *  offset 0                  InstanceHeader (128 bytes)
+ *  offset payload_offset     elements in row-major order, payload_bytes long
+ *
+ * payload_offset is a multiple of INSTANCE_ALIGNMENT, so the payload can be mapped and used
+ * in place. All fields are stored in the byte order of the machine that wrote the file;
+ * byte_order lets a reader reject files written with the other one.
+ */
+
+#ifndef InstanceFormat_hpp
+#define InstanceFormat_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#define INSTANCE_MAGIC "SRCHINST"
+#define INSTANCE_VERSION 1
+#define INSTANCE_BYTE_ORDER 0x01020304u
+#define INSTANCE_ALIGNMENT 4096
+#define INSTANCE_MAX_DIMS 8
+
+/*! Element layout of the payload. */
+enum InstanceLayout{
+    INSTANCE_ROW_MAJOR = 0
+};
+
+/*! Sortedness flags. */
+enum InstanceFlags{
+    INSTANCE_SORTED = 1u << 0 /* Non-decreasing along every axis. */
+};
+
+/*! Element type codes. */
+enum InstanceType{
+    INSTANCE_UNKNOWN = 0,
+    INSTANCE_INT8, INSTANCE_INT16, INSTANCE_INT32, INSTANCE_INT64,
+    INSTANCE_UINT8, INSTANCE_UINT16, INSTANCE_UINT32, INSTANCE_UINT64,
+    INSTANCE_FLOAT, INSTANCE_DOUBLE
+};
+
+/*!
+ * \brief Type code of an element type.
+ */
+template<class T> struct InstanceTypeCode{ static const std::uint32_t value = INSTANCE_UNKNOWN; };
+template<> struct InstanceTypeCode<std::int8_t>{ static const std::uint32_t value = INSTANCE_INT8; };
+template<> struct InstanceTypeCode<std::int16_t>{ static const std::uint32_t value = INSTANCE_INT16; };
+template<> struct InstanceTypeCode<std::int32_t>{ static const std::uint32_t value = INSTANCE_INT32; };
+template<> struct InstanceTypeCode<std::int64_t>{ static const std::uint32_t value = INSTANCE_INT64; };
+template<> struct InstanceTypeCode<std::uint8_t>{ static const std::uint32_t value = INSTANCE_UINT8; };
+template<> struct InstanceTypeCode<std::uint16_t>{ static const std::uint32_t value = INSTANCE_UINT16; };
+template<> struct InstanceTypeCode<std::uint32_t>{ static const std::uint32_t value = INSTANCE_UINT32; };
+template<> struct InstanceTypeCode<std::uint64_t>{ static const std::uint32_t value = INSTANCE_UINT64; };
+template<> struct InstanceTypeCode<float>{ static const std::uint32_t value = INSTANCE_FLOAT; };
+template<> struct InstanceTypeCode<double>{ static const std::uint32_t value = INSTANCE_DOUBLE; };
+
+/*!
+ * \brief Header at the start of every instance file.
+ */
+struct InstanceHeader{
+    char magic[8];                  /* INSTANCE_MAGIC, without the terminating zero. */
+    std::uint32_t version;          /* INSTANCE_VERSION. */
+    std::uint32_t byte_order;       /* INSTANCE_BYTE_ORDER as written by the producer. */
+    std::uint32_t type;             /* InstanceType of the elements. */
+    std::uint32_t element_size;     /* sizeof of one element. */
+    std::uint32_t dims;             /* Number of dimensions, 1 to INSTANCE_MAX_DIMS. */
+    std::uint32_t layout;           /* InstanceLayout. */
+    std::uint32_t flags;            /* InstanceFlags. */
+    std::uint32_t reserved0;
+    std::uint64_t extents[INSTANCE_MAX_DIMS]; /* Size of every dimension; unused entries are 0. */
+    std::uint64_t payload_offset;   /* Start of the elements, multiple of INSTANCE_ALIGNMENT. */
+    std::uint64_t payload_bytes;    /* Size of the elements. */
+    std::uint64_t reserved1;
+};
+
+static_assert(sizeof(InstanceHeader) == 128, "InstanceHeader must be 128 bytes");
+
+/*!
+ * \brief Fills a header for an instance of element type T.
+ * \param h header.
+ * \param dims number of dimensions.
+ * \param extents size of every dimension.
+ * \param flags sortedness flags.
+ */
+template<class T>
+void InitInstanceHeader(InstanceHeader& h, std::uint32_t dims, const std::uint64_t* extents, std::uint32_t flags){
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, INSTANCE_MAGIC, 8);
+    h.version = INSTANCE_VERSION;
+    h.byte_order = INSTANCE_BYTE_ORDER;
+    h.type = InstanceTypeCode<T>::value;
+    h.element_size = sizeof(T);
+    h.dims = dims;
+    h.layout = INSTANCE_ROW_MAJOR;
+    h.flags = flags;
+    std::uint64_t count = 1;
+    for( std::uint32_t d = 0; d < dims; ++d){
+        h.extents[d] = extents[d];
+        count *= extents[d];
+    }
+    h.payload_offset = INSTANCE_ALIGNMENT;
+    h.payload_bytes = count * sizeof(T);
+}
+
+/*!
+ * \brief Checks a header read from a file. Returns 0 if it is valid, or a message describing the problem.
+ * \param h header.
+ * \param file_size size of the file.
+ */
+inline const char* CheckInstanceHeader(const InstanceHeader& h, std::uint64_t file_size){
+    if(std::memcmp(h.magic, INSTANCE_MAGIC, 8) != 0)
+        return "not an instance file";
+    if(h.byte_order != INSTANCE_BYTE_ORDER)
+        return "instance written with another byte order";
+    if(h.version != INSTANCE_VERSION)
+        return "unsupported instance version";
+    if(h.dims < 1 || h.dims > INSTANCE_MAX_DIMS)
+        return "invalid number of dimensions";
+    if(h.layout != INSTANCE_ROW_MAJOR)
+        return "unsupported layout";
+    if(h.payload_offset % INSTANCE_ALIGNMENT != 0)
+        return "misaligned payload";
+    std::uint64_t count = 1;
+    for( std::uint32_t d = 0; d < h.dims; ++d)
+        count *= h.extents[d];
+    if(count * h.element_size != h.payload_bytes)
+        return "payload size does not match the extents";
+    if(h.payload_offset + h.payload_bytes > file_size)
+        return "truncated instance file";
+    return 0;
+}
+
+#endif
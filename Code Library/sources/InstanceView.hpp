@@ -0,0 +1,365 @@
+/** \file InstanceView.hpp
+ * Strided views over flat buffers and dimension-generic search functions.
+ */
+
+/*
+ *  InstanceView.hpp
+ *
+ *  Instituto de Informatica - UFG
+ *
+ */
+
+#ifndef InstanceView_hpp
+#define InstanceView_hpp
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*!
+ * \brief Random access iterator over any source that provides operator[].
+ *
+ * The source is stored by value, so it should be a light handle (a view, a row proxy or a pointer wrapper).
+ * Dereferencing returns whatever source[i] returns, which lets views, row proxies and compressed containers
+ * be passed as first/last to the search templates in SearchAlgorithms.hpp.
+ */
+template<class Source>
+class IndexedIterator{
+public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef decltype(std::declval<const Source&>()[std::ptrdiff_t()]) reference;
+    typedef typename std::decay<reference>::type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef void pointer;
+
+    IndexedIterator() : src(), i(0){}
+    IndexedIterator(const Source& src, std::ptrdiff_t i) : src(src), i(i){}
+
+    reference operator*() const{ return src[i]; }
+    reference operator[](difference_type n) const{ return src[i+n]; }
+
+    IndexedIterator& operator++(){ ++i; return *this; }
+    IndexedIterator& operator--(){ --i; return *this; }
+    IndexedIterator operator++(int){ IndexedIterator t = *this; ++i; return t; }
+    IndexedIterator operator--(int){ IndexedIterator t = *this; --i; return t; }
+    IndexedIterator& operator+=(difference_type n){ i += n; return *this; }
+    IndexedIterator& operator-=(difference_type n){ i -= n; return *this; }
+    IndexedIterator operator+(difference_type n) const{ return IndexedIterator(src, i+n); }
+    IndexedIterator operator-(difference_type n) const{ return IndexedIterator(src, i-n); }
+    friend IndexedIterator operator+(difference_type n, const IndexedIterator& it){ return it + n; }
+    difference_type operator-(const IndexedIterator& o) const{ return i - o.i; }
+
+    bool operator==(const IndexedIterator& o) const{ return i == o.i; }
+    bool operator!=(const IndexedIterator& o) const{ return i != o.i; }
+    bool operator<(const IndexedIterator& o) const{ return i < o.i; }
+    bool operator>(const IndexedIterator& o) const{ return i > o.i; }
+    bool operator<=(const IndexedIterator& o) const{ return i <= o.i; }
+    bool operator>=(const IndexedIterator& o) const{ return i >= o.i; }
+
+    /*!
+     * \brief Position of the iterator in its source.
+     */
+    difference_type index() const{ return i; }
+
+private:
+    Source src;
+    difference_type i;
+};
+
+
+/*!
+ * \brief D-dimensional view of a buffer: base pointer plus extents and strides (in elements).
+ *
+ * When UnitInner is true the stride of the last axis is the compile-time constant 1, so loops along
+ * that axis are contiguous. view[i] fixes the first axis and returns a (D-1)-dimensional view,
+ * or a reference to the element when D is 1.
+ */
+template<class T, std::size_t D, bool UnitInner = true>
+class StridedView{
+    static_assert(D >= 1, "StridedView needs at least one dimension");
+public:
+    typedef T value_type;
+    typedef std::array<std::ptrdiff_t, D> index_type;
+    typedef IndexedIterator<StridedView> iterator;
+
+    StridedView() : ptr(0){
+        ext.fill(0);
+        str.fill(0);
+    }
+
+    /*!
+     * \brief View of a dense row-major buffer.
+     * \param data pointer to the first element.
+     * \param extents size of every dimension.
+     */
+    StridedView(T* data, const index_type& extents) : ptr(data), ext(extents){
+        std::ptrdiff_t s = 1;
+        for( std::size_t d = D; d-- > 0; ){
+            str[d] = s;
+            s *= ext[d];
+        }
+    }
+
+    /*!
+     * \brief View with explicit strides. The last stride must be 1 when UnitInner is true.
+     * \param data pointer to the first element.
+     * \param extents size of every dimension.
+     * \param strides distance, in elements, between consecutive positions of every dimension.
+     */
+    StridedView(T* data, const index_type& extents, const index_type& strides) : ptr(data), ext(extents), str(strides){}
+
+    std::ptrdiff_t size() const{ return ext[0]; }
+    std::ptrdiff_t extent(std::size_t d) const{ return ext[d]; }
+    std::ptrdiff_t stride(std::size_t d) const{ return (UnitInner && d == D-1)? 1 : str[d]; }
+    const index_type& extents() const{ return ext; }
+    T* data() const{ return ptr; }
+
+    /*!
+     * \brief Total number of elements.
+     */
+    std::ptrdiff_t count() const{
+        std::ptrdiff_t c = 1;
+        for( std::size_t d = 0; d < D; ++d)
+            c *= ext[d];
+        return c;
+    }
+
+    /*!
+     * \brief Offset of a position from the base pointer.
+     */
+    std::ptrdiff_t offset(const index_type& p) const{
+        std::ptrdiff_t o = 0;
+        for( std::size_t d = 0; d < D; ++d)
+            o += p[d]*stride(d);
+        return o;
+    }
+
+    T& operator()(const index_type& p) const{
+        return ptr[offset(p)];
+    }
+
+    decltype(auto) operator[](std::ptrdiff_t i) const{
+        if constexpr (D == 1){
+            return ptr[i*stride(0)];
+        }else{
+            std::array<std::ptrdiff_t, D-1> e, s;
+            for( std::size_t d = 1; d < D; ++d){
+                e[d-1] = ext[d];
+                s[d-1] = str[d];
+            }
+            return StridedView<T, D-1, UnitInner>(ptr + i*str[0], e, s);
+        }
+    }
+
+    iterator begin() const{ return iterator(*this, 0); }
+    iterator end() const{ return iterator(*this, ext[0]); }
+
+private:
+    T* ptr;
+    index_type ext;
+    index_type str;
+};
+
+
+/*!
+ * \brief Dense row-major D-dimensional array that owns its buffer.
+ */
+template<class T, std::size_t D, class Allocator = std::allocator<T> >
+class DenseArray{
+public:
+    typedef std::array<std::ptrdiff_t, D> index_type;
+
+    DenseArray(){
+        ext.fill(0);
+    }
+
+    /*!
+     * \brief Allocates an array.
+     * \param extents size of every dimension.
+     */
+    explicit DenseArray(const index_type& extents, const Allocator& alloc = Allocator()) : ext(extents), buf(alloc){
+        std::ptrdiff_t c = 1;
+        for( std::size_t d = 0; d < D; ++d)
+            c *= ext[d];
+        buf.resize(c);
+    }
+
+    StridedView<T, D> view(){ return StridedView<T, D>(buf.data(), ext); }
+    StridedView<const T, D> view() const{ return StridedView<const T, D>(buf.data(), ext); }
+
+    typename StridedView<T, D>::iterator begin(){ return view().begin(); }
+    typename StridedView<T, D>::iterator end(){ return view().end(); }
+    typename StridedView<const T, D>::iterator begin() const{ return view().begin(); }
+    typename StridedView<const T, D>::iterator end() const{ return view().end(); }
+
+    T* data(){ return buf.data(); }
+    const T* data() const{ return buf.data(); }
+    const index_type& extents() const{ return ext; }
+
+private:
+    index_type ext;
+    std::vector<T, Allocator> buf;
+};
+
+
+//! Dimension-generic search functions.
+
+/*!
+ * \brief Binary search function along one axis of a view.
+ * \param view array view.
+ * \param axis axis searched.
+ * \param p position of the line; p[axis] is ignored.
+ * \param lo first position of the line.
+ * \param hi last position of the line.
+ * \param  value is the search key.
+ * \return position of value, or the last position holding a smaller element (lo-1 if none).
+ */
+template<class T, std::size_t D, bool UnitInner, class U>
+std::ptrdiff_t binary_search_axis(const StridedView<T, D, UnitInner>& view, std::size_t axis, std::array<std::ptrdiff_t, D> p, std::ptrdiff_t lo, std::ptrdiff_t hi, const U& value){
+    p[axis] = 0;
+    const T* line = view.data() + view.offset(p);
+    if(UnitInner && axis == D-1){
+        /* Unit stride: contiguous search. */
+        const T* it = std::lower_bound(line + lo, line + hi + 1, value);
+        if(it != line + hi + 1 && *it == value)
+            return it - line;
+        return (it - line) - 1;
+    }
+    std::ptrdiff_t s = view.stride(axis);
+    while(lo <= hi){
+        std::ptrdiff_t mid = (lo+hi)>>1;
+        if( line[mid*s] < value)
+            lo = mid+1;
+        else if( line[mid*s] > value)
+            hi = mid-1;
+        else
+            return mid;
+    }
+    return hi;
+}
+
+/*!
+ * \brief Saddleback search function on the plane spanned by two axes of a view.
+ * \param view array view.
+ * \param a axis walked from its lowest position.
+ * \param b axis walked from its highest position.
+ * \param lo lowest corner of the box; the coordinates of the other axes are taken from it.
+ * \param hi highest corner of the box.
+ * \param  value is the search key.
+ */
+template<class T, std::size_t D, bool UnitInner, class U>
+bool saddleback_search(const StridedView<T, D, UnitInner>& view, std::size_t a, std::size_t b, const std::array<std::ptrdiff_t, D>& lo, const std::array<std::ptrdiff_t, D>& hi, const U& value){
+    std::array<std::ptrdiff_t, D> p = lo;
+    p[b] = hi[b];
+    const T* it = view.data() + view.offset(p);
+    std::ptrdiff_t sa = view.stride(a), sb = view.stride(b);
+    std::ptrdiff_t x = lo[a], y = hi[b];
+    while(x <= hi[a] && y >= lo[b]){
+        if(*it == value)
+            return true;
+        if(*it > value){
+            --y;
+            it -= sb;
+        }else{
+            ++x;
+            it += sa;
+        }
+    }
+    return false;
+}
+
+/*!
+ * \brief MAHL_e function for views of any dimension.
+ *
+ * The largest axis is binary searched on the line through the middle of the other axes. The element found
+ * splits the box into a lower corner (all smaller than value) and an upper corner (all larger), and the rest
+ * of the box is covered by 2(D-1) disjoint boxes. Boxes with at most two non-trivial axes are solved by
+ * binary or saddleback search.
+ * \param view array view.
+ * \param lo lowest corner of the box.
+ * \param hi highest corner of the box.
+ * \param  value is the search key.
+ */
+template<class T, std::size_t D, bool UnitInner, class U>
+bool MAHL_e(const StridedView<T, D, UnitInner>& view, const std::array<std::ptrdiff_t, D>& lo, const std::array<std::ptrdiff_t, D>& hi, const U& value){
+    std::size_t axes[D];
+    std::size_t wide = 0, a = 0;
+    for( std::size_t d = 0; d < D; ++d){
+        if(lo[d] > hi[d])
+            return false;
+        if(hi[d] > lo[d])
+            axes[wide++] = d;
+        if(hi[d]-lo[d] > hi[a]-lo[a])
+            a = d;
+    }
+    /* The corners bound every element of the box. */
+    if(value < view(lo) || view(hi) < value)
+        return false;
+    if(wide == 0)
+        return view(lo) == value;
+    if(wide == 1){
+        std::ptrdiff_t h = binary_search_axis(view, axes[0], lo, lo[axes[0]], hi[axes[0]], value);
+        std::array<std::ptrdiff_t, D> p = lo;
+        p[axes[0]] = h;
+        return h >= lo[axes[0]] && view(p) == value;
+    }
+    if(wide == 2)
+        return saddleback_search(view, axes[0], axes[1], lo, hi, value);
+
+    std::array<std::ptrdiff_t, D> mid;
+    for( std::size_t d = 0; d < D; ++d)
+        mid[d] = (lo[d] + hi[d]) >> 1;
+    std::ptrdiff_t h = binary_search_axis(view, a, mid, lo[a], hi[a], value);
+    mid[a] = h;
+    if(h >= lo[a] && view(mid) == value)
+        return true;
+
+    /* Below the split on axis a: leave the lower corner through the first axis t above its middle. */
+    std::array<std::ptrdiff_t, D> l = lo, r = hi;
+    r[a] = h;
+    for( std::size_t d = 0; d < D; ++d){
+        if(d == a)
+            continue;
+        std::array<std::ptrdiff_t, D> bl = l, br = r;
+        bl[d] = mid[d]+1;
+        if(MAHL_e(view, bl, br, value))
+            return true;
+        r[d] = mid[d];
+    }
+    /* Above the split on axis a: leave the upper corner through the first axis t below its middle. */
+    l = lo;
+    r = hi;
+    l[a] = h+1;
+    for( std::size_t d = 0; d < D; ++d){
+        if(d == a)
+            continue;
+        std::array<std::ptrdiff_t, D> bl = l, br = r;
+        br[d] = mid[d]-1;
+        if(MAHL_e(view, bl, br, value))
+            return true;
+        l[d] = mid[d];
+    }
+    return false;
+}
+
+/*!
+ * \brief MAHL_e function for views of any dimension.
+ * \param view array view.
+ * \param  value is the search key.
+ */
+template<class T, std::size_t D, bool UnitInner, class U>
+bool MAHL_e(const StridedView<T, D, UnitInner>& view, const U& value){
+    std::array<std::ptrdiff_t, D> lo, hi;
+    for( std::size_t d = 0; d < D; ++d){
+        lo[d] = 0;
+        hi[d] = view.extent(d)-1;
+    }
+    return MAHL_e(view, lo, hi, value);
+}
+
+#endif
@@ -0,0 +1,310 @@
+/** \file LazyInstance.hpp
+ * Virtual instances that are regenerated on demand from checkpoints instead of being stored.
+ */
+
+/*
+ *  LazyInstance.hpp
+ *
+ *  Instituto de Informatica - UFG
+ *
+ */
+
+/*
+ * The parallel generators of GeneratorInstance.hpp draw the increment of every element from a counter-based
+ * generator, so any block of an instance can be rebuilt from the value it starts from. A lazy instance keeps
+ * only those starting values (checkpoints, one per block or tile) and an LRU cache of rebuilt blocks; its memory is bounded by
+ * the checkpoints plus the cache, whatever the size of the instance.
+ *
+ * Lazy instances are not thread-safe: the cache is updated by every access.
+ */
+
+#ifndef LazyInstance_hpp
+#define LazyInstance_hpp
+
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "GeneratorInstance.hpp"
+#include "InstanceView.hpp"
+
+/*!
+ * \brief LRU cache of fixed-size blocks identified by an integer.
+ */
+template<class T>
+class BlockCache{
+public:
+    /*!
+     * \param block_size number of elements of a block.
+     * \param capacity maximum number of cached blocks.
+     */
+    BlockCache(std::size_t block_size, std::size_t capacity) : size(block_size), cap(capacity < 1? 1 : capacity), last_id(-1), last(0), hits(0), misses(0){}
+
+    /*!
+     * \brief Returns the block id, calling fill(id, buffer) to rebuild it when it is not cached.
+     */
+    template<class Fill>
+    const T* get(std::int64_t id, Fill fill){
+        if(id == last_id)
+            return last;
+        typename std::unordered_map<std::int64_t, Entry>::iterator it = map.find(id);
+        if(it != map.end()){
+            ++hits;
+            order.splice(order.begin(), order, it->second.pos);
+        }else{
+            ++misses;
+            std::vector<T> buf;
+            if(map.size() >= cap){
+                /* Reuse the buffer of the least recently used block. */
+                std::int64_t victim = order.back();
+                order.pop_back();
+                buf.swap(map[victim].data);
+                map.erase(victim);
+            }
+            buf.resize(size);
+            fill(id, buf.data());
+            order.push_front(id);
+            Entry& e = map[id];
+            e.data.swap(buf);
+            e.pos = order.begin();
+            it = map.find(id);
+        }
+        last_id = id;
+        last = it->second.data.data();
+        return last;
+    }
+
+    std::size_t capacity() const{ return cap; }
+    std::uint64_t hit_count() const{ return hits; }
+    std::uint64_t miss_count() const{ return misses; }
+
+private:
+    struct Entry{
+        std::vector<T> data;
+        std::list<std::int64_t>::iterator pos;
+    };
+    std::size_t size, cap;
+    std::list<std::int64_t> order; /* Most recently used first. */
+    std::unordered_map<std::int64_t, Entry> map;
+    std::int64_t last_id;
+    const T* last;
+    std::uint64_t hits, misses;
+};
+
+
+/*!
+ * \brief One-dimensional instance of LinearDistribution_Parallel that is never materialized.
+ *
+ * Stores the value before every block of block_size elements. Values are the same as those of
+ * LinearDistribution_Parallel with the same arguments for integer types, and also for floating types
+ * when block_size is GENERATOR_BLOCK. begin() and end() can be passed to the one-dimensional searches.
+ */
+template<class T>
+class LazyInstance{
+public:
+    struct Accessor{
+        const LazyInstance* p;
+        Accessor(const LazyInstance* p = 0) : p(p){}
+        T operator[](std::ptrdiff_t i) const{ return (*p)[i]; }
+    };
+    typedef IndexedIterator<Accessor> iterator;
+
+    /*!
+     * \param n number of elements.
+     * \param dist distribution (LID, LDD or LND).
+     * \param  min_value initial value of sequence.
+     * \param max_value maximum sequence offset.
+     * \param seed random seed.
+     * \param block_size elements per checkpoint.
+     * \param cache_blocks number of blocks kept in memory.
+     * \param threads number of threads used to compute the checkpoints (0 for one per hardware thread).
+     */
+    LazyInstance(std::int64_t n, int dist, const T& min_value, const T& max_value, std::uint64_t seed,
+                 std::int64_t block_size = GENERATOR_BLOCK, std::size_t cache_blocks = 64, unsigned threads = 0)
+        : n(n), dist(dist), seed(seed), block(block_size), cache(block_size, cache_blocks){
+        offset = n > 0? (max_value - min_value+1.) /(T)n : 0;
+        std::int64_t blocks = (n + block - 1) / block;
+        checkpoints.resize(blocks);
+        /* Block sums in parallel, then their scan in block order. */
+        ParallelFor(blocks, threads, [&](std::int64_t b){
+            std::int64_t lo = b * block, hi = std::min(lo + block, n);
+            T sum = 0;
+            for( std::int64_t i = lo; i < hi; ++i)
+                sum += increment(i);
+            checkpoints[b] = sum;
+        });
+        T running = min_value;
+        for( std::int64_t b = 0; b < blocks; ++b){
+            T s = checkpoints[b];
+            checkpoints[b] = running;
+            running += s;
+        }
+    }
+
+    T operator[](std::ptrdiff_t i) const{
+        const T* data = cache.get(i / block, [this](std::int64_t b, T* buf){ rebuild(b, buf); });
+        return data[i % block];
+    }
+
+    std::int64_t size() const{ return n; }
+    iterator begin() const{ return iterator(Accessor(this), 0); }
+    iterator end() const{ return iterator(Accessor(this), n); }
+
+    /*!
+     * \brief Bytes used by the checkpoints and the cache.
+     */
+    std::size_t memory() const{
+        return checkpoints.size()*sizeof(T) + cache.capacity()*block*sizeof(T);
+    }
+
+    const BlockCache<T>& block_cache() const{ return cache; }
+
+private:
+    T increment(std::int64_t i) const{
+        return (T)DistributionIncrement(dist, offset, CounterUniform(seed, i));
+    }
+
+    void rebuild(std::int64_t b, T* buf) const{
+        std::int64_t lo = b * block, hi = std::min(lo + block, n);
+        T value = checkpoints[b];
+        for( std::int64_t i = lo; i < hi; ++i){
+            value = increment(i) + value;
+            buf[i-lo] = value;
+        }
+    }
+
+    std::int64_t n;
+    int dist;
+    std::uint64_t seed;
+    std::int64_t block;
+    T offset;
+    std::vector<T> checkpoints;
+    mutable BlockCache<T> cache;
+};
+
+
+/*!
+ * \brief Two-dimensional sorted instance that is never materialized.
+ *
+ * The matrix is split in tiles of tile x tile elements. Every tile is filled like LinearDistribution_2D_Parallel,
+ * with the counter-based increment of each element, but from a base value instead of the elements above and to
+ * the left of the tile: the base is the largest element of the tiles above and to its left, so the matrix is
+ * sorted along rows and columns. A tile is rebuilt from its base alone, which is the only checkpoint stored.
+ * The values differ from those of LinearDistribution_2D_Parallel, where every element depends on the whole
+ * region above and to the left of it and no tile can be rebuilt from a bounded state. begin() and end()
+ * iterate over row proxies and can be passed to the two-dimensional searches.
+ */
+template<class T>
+class LazyInstance_2D{
+public:
+    class Row{
+    public:
+        typedef IndexedIterator<Row> iterator;
+        Row(const LazyInstance_2D* p = 0, std::ptrdiff_t i = 0) : p(p), i(i){}
+        T operator[](std::ptrdiff_t j) const{ return p->at(i, j); }
+        std::ptrdiff_t size() const{ return p->N; }
+        iterator begin() const{ return iterator(*this, 0); }
+        iterator end() const{ return iterator(*this, p->N); }
+    private:
+        const LazyInstance_2D* p;
+        std::ptrdiff_t i;
+    };
+    struct Accessor{
+        const LazyInstance_2D* p;
+        Accessor(const LazyInstance_2D* p = 0) : p(p){}
+        Row operator[](std::ptrdiff_t i) const{ return Row(p, i); }
+    };
+    typedef IndexedIterator<Accessor> iterator;
+
+    /*!
+     * \param M size of the first dimension.
+     * \param N size of the second dimension.
+     * \param dist distribution (LID, LDD or LND).
+     * \param  min_value initial value of sequence.
+     * \param max_value maximum sequence offset.
+     * \param seed random seed.
+     * \param tile side of a tile.
+     * \param cache_tiles number of tiles kept in memory.
+     * \param threads number of threads used to compute the bases (0 for one per hardware thread).
+     */
+    LazyInstance_2D(std::int64_t M, std::int64_t N, int dist, const T& min_value, const T& max_value, std::uint64_t seed,
+                    int tile = 64, std::size_t cache_tiles = 256, unsigned threads = 0)
+        : M(M), N(N), dist(dist), seed(seed), B(tile), cache((std::size_t)tile*tile, cache_tiles){
+        TM = (M + B - 1) / B;
+        TN = (N + B - 1) / B;
+        /* The longest chain of increments crosses TM+TN-1 tiles corner to corner. */
+        offset = (max_value - min_value+1.) /(T)((TM+TN-1.) * (std::min<std::int64_t>(B, M) + std::min<std::int64_t>(B, N) - 1.));
+        base.resize((std::size_t)TM*TN);
+        /* The base of a tile needs the largest elements of the tiles above and to its left, so the tiles of
+           an anti-diagonal a + b = d are filled in parallel, as in LinearDistribution_2D_Parallel. */
+        std::vector<T> high((std::size_t)TM*TN);
+        for( std::int64_t d = 0; d <= TM + TN - 2; ++d){
+            std::int64_t a0 = std::max<std::int64_t>(0, d - TN + 1), a1 = std::min(d, TM - 1);
+            ParallelFor(a1 - a0 + 1, threads, [&](std::int64_t t){
+                std::int64_t a = a0 + t, b = d - a;
+                std::size_t id = (std::size_t)a*TN + b;
+                T c = min_value;
+                if(a > 0)
+                    c = high[id - TN];
+                if(b > 0)
+                    c = a > 0? std::max(c, high[id - 1]) : high[id - 1];
+                base[id] = c;
+                std::vector<T> buf((std::size_t)B*B);
+                fill(a, b, buf.data());
+                std::int64_t rows = std::min<std::int64_t>(B, M - a*B), cols = std::min<std::int64_t>(B, N - b*B);
+                high[id] = buf[(std::size_t)(rows-1)*B + cols-1];
+            });
+        }
+    }
+
+    T at(std::ptrdiff_t i, std::ptrdiff_t j) const{
+        std::int64_t a = i / B, b = j / B;
+        const T* data = cache.get(a*TN + b, [this](std::int64_t t, T* buf){ fill(t / TN, t % TN, buf); });
+        return data[(i - a*B)*B + (j - b*B)];
+    }
+
+    Row operator[](std::ptrdiff_t i) const{ return Row(this, i); }
+    std::int64_t rows() const{ return M; }
+    std::int64_t cols() const{ return N; }
+    iterator begin() const{ return iterator(Accessor(this), 0); }
+    iterator end() const{ return iterator(Accessor(this), M); }
+
+    /*!
+     * \brief Bytes used by the checkpoints and the cache.
+     */
+    std::size_t memory() const{
+        return base.size()*sizeof(T) + cache.capacity()*B*B*sizeof(T);
+    }
+
+    const BlockCache<T>& block_cache() const{ return cache; }
+
+private:
+    /* Rows of a tile buffer, indexed from the top left corner of the tile. */
+    struct Tile{
+        T* buf;
+        int B;
+        T* operator[](int i) const{ return buf + (std::size_t)i*B; }
+    };
+
+    void fill(std::int64_t a, std::int64_t b, T* buf) const{
+        Tile t = {buf, B};
+        std::int64_t i0 = a*B, j0 = b*B;
+        SortedFill_2D(t, 0, (int)std::min<std::int64_t>(B, M - i0), 0, (int)std::min<std::int64_t>(B, N - j0), base[(std::size_t)(a*TN + b)], [this, i0, j0](int i, int j){
+            return (T)DistributionIncrement(dist, offset, CounterUniform(seed, (std::uint64_t)(i0+i)*N + j0+j));
+        });
+    }
+
+    std::int64_t M, N;
+    int dist;
+    std::uint64_t seed;
+    T offset;
+    int B; /* Side of a tile. */
+    std::int64_t TM, TN; /* Tiles per dimension. */
+    std::vector<T> base; /* Value every tile starts from. */
+    mutable BlockCache<T> cache;
+};
+
+#endif
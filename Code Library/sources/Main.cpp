@@ -1,14 +1,32 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <chrono>
+#include <random>
 
 
 #include "SearchAlgorithms.hpp"
 #include "GeneratorInstance.hpp"
+#include "FractionalCascading.hpp"
+#include "SearchPlanner.hpp"
+#include "NumaReplicas.hpp"
+#include "ShardedSearch.hpp"
 #include "../headers/CPUTimer.hpp"
 
 using namespace std;
 
+#define CALIBRATION_FILE "search_calibration.txt"
+
+ShapeDispatcher dispatcher;
+
+/*!
+ * \brief Calibrates the dispatcher before its first search, from CALIBRATION_FILE if option 6 saved one.
+ */
+void prepare_dispatcher(){
+    if(!dispatcher.is_calibrated() && !dispatcher.load(CALIBRATION_FILE))
+        dispatcher.calibrate();
+}
+
 
 void test_D1(int N, int ld, int min_value, int interval){
     vector<int> A(N);
@@ -168,6 +186,7 @@ void test_D2(int M, int N, int ld, int min_value, int interval){
     }
     else
         return;
+    FractionalCascade<int> cascade(A.begin(), A.end());
     int query;
     printf("How many queries in the range: ");
     scanf(" %d", &query);
@@ -211,6 +230,37 @@ void test_D2(int M, int N, int ld, int min_value, int interval){
             printf("NO\n");
         }
         printf("timer: %.10lf\n", timer.getCronoTotalSecs());
+
+        timer.reset();
+        found = false;
+        timer.start();
+        found = shen_search(A.begin(), A.end(), key, cascade);
+        timer.stop();
+
+        printf("Shen search (fractional cascading): ");
+        if(found == true){
+            printf("YES\n");
+        }
+        else{
+            printf("NO\n");
+        }
+        printf("timer: %.10lf\n", timer.getCronoTotalSecs());
+
+        prepare_dispatcher();
+        timer.reset();
+        found = false;
+        timer.start();
+        found = dispatcher.search_2D(A.begin(), A.end(), key);
+        timer.stop();
+
+        printf("Dispatched search (%s): ", SearchAlgorithmName(dispatcher.choose_2D(M, N)));
+        if(found == true){
+            printf("YES\n");
+        }
+        else{
+            printf("NO\n");
+        }
+        printf("timer: %.10lf\n", timer.getCronoTotalSecs());
         printf("----------------------------------------------------------------------\n\n");
         query--;
     }
@@ -285,19 +335,159 @@ void test_D3(int M, int N, int P, int ld, int min_value, int interval){
         }
         printf("timer: %.10lf\n", timer.getCronoTotalSecs());
 
+        prepare_dispatcher();
+        timer.reset();
+        found = false;
+        timer.start();
+        found = dispatcher.search_3D(A.begin(), A.end(), key);
+        timer.stop();
+        printf("Dispatched search (%s): ", SearchAlgorithmName(dispatcher.choose_3D(M, N, P)));
+        if(found == true){
+            printf("YES\n");
+        }
+        else{
+            printf("NO\n");
+        }
+        printf("timer: %.10lf\n", timer.getCronoTotalSecs());
+
         printf("----------------------------------------------------------------------\n\n");
         query--;
     }
     printf("\n");
 }
 
+/*!
+ * \brief Queries per second of a NumaQueryEngine over the given copies (wall-clock time, all workers).
+ */
+template<class T, std::size_t D, class Search>
+double numa_throughput(const NumaReplicas<T, D>& replicas, Search search, const vector<T>& keys, vector<char>& results){
+    auto engine = make_numa_query_engine(replicas, search);
+    unique_ptr<bool[]> out(new bool[keys.size()]);
+    auto start = chrono::steady_clock::now();
+    engine->run(keys.data(), keys.size(), out.get());
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    results.assign(out.get(), out.get() + keys.size());
+    return keys.size() / secs;
+}
+
+/*!
+ * \brief Compares one interleaved copy of the instance with one copy per NUMA node.
+ */
+template<class T, std::size_t D, class ForwardIt, class Search>
+void compare_numa(ForwardIt first, ForwardIt last, Search search, const vector<T>& keys){
+    vector<char> base, local;
+    printf("NUMA nodes: %d\n", numa_nodes());
+
+    NumaReplicas<T, D> single(first, last, false);
+    double q1 = numa_throughput(single, search, keys, base);
+    printf("Interleaved single copy: %.0f queries/s\n", q1);
+    single.report(stdout);
+
+    NumaReplicas<T, D> replicas(first, last, true);
+    double q2 = numa_throughput(replicas, search, keys, local);
+    printf("One copy per node:       %.0f queries/s (%.2fx, %.1f MB)\n", q2, q2 / q1, replicas.memory() / 1048576.);
+    replicas.report(stdout);
+
+    if(base != local)
+        printf("Results differ!\n");
+}
+
+void test_numa(int dimension, int N, int queries){
+    mt19937 gen(1);
+    vector<int> keys(queries);
+    printf("----------------------------------------------------------------------\n\n");
+    if(dimension == 1){
+        vector<int> A(N);
+        LinearIncreasingDistribution(A.begin(), A.end(), 0, 1 << 28);
+        for( int q = 0; q < queries; ++q)
+            keys[q] = q % 2? A[gen() % N] : gen() % (1 << 28);
+        printf("N = %d, %d queries, binary search\n", N, queries);
+        compare_numa<int, 1>(A.begin(), A.end(), [](auto f, auto l, int v){ return std::binary_search(f, l, v); }, keys);
+    }
+    else if(dimension == 2){
+        vector<vector<int> > A(N, vector<int>(N));
+        LinearIncreasingDistribution_2D(A.begin(), A.end(), 0, 1 << 20);
+        for( int q = 0; q < queries; ++q)
+            keys[q] = q % 2? A[gen() % N][gen() % N] : gen() % (1 << 20);
+        printf("N x N = %d x %d, %d queries, saddleback search\n", N, N, queries);
+        compare_numa<int, 2>(A.begin(), A.end(), [](auto f, auto l, int v){ return saddleback_search(f, l, v); }, keys);
+    }
+    else if(dimension == 3){
+        vector<vector<vector<int> > > A(N, vector<vector<int> >(N, vector<int>(N)));
+        LinearIncreasingDistribution_3D(A.begin(), A.end(), 0, 1 << 20);
+        for( int q = 0; q < queries; ++q)
+            keys[q] = q % 2? A[gen() % N][gen() % N][gen() % N] : gen() % (1 << 20);
+        printf("N x N x N = %d x %d x %d, %d queries, Shen3D search\n", N, N, N, queries);
+        compare_numa<int, 3>(A.begin(), A.end(), [](auto f, auto l, int v){ return MAHL_e(f, l, v); }, keys);
+    }
+    printf("----------------------------------------------------------------------\n\n");
+}
+
+/*!
+ * \brief Compares searching the whole instance in this process with searching it split across worker processes.
+ */
+template<class T, std::size_t D, class ForwardIt, class Search>
+void compare_shards(ForwardIt first, ForwardIt last, int shards, Search search, const vector<T>& keys){
+    vector<char> local(keys.size());
+    auto start = chrono::steady_clock::now();
+    for( size_t q = 0; q < keys.size(); ++q)
+        local[q] = search(first, last, keys[q]);
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printf("Single process: %.0f queries/s\n", keys.size() / secs);
+
+    auto sharded = make_sharded_search<T, D>(first, last, shards, search);
+    if(!sharded->is_running()){
+        printf("Cannot start the workers: %s\n", sharded->error());
+        return;
+    }
+    unique_ptr<bool[]> out(new bool[keys.size()]);
+    start = chrono::steady_clock::now();
+    bool ok = sharded->search(keys.data(), keys.size(), out.get());
+    secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if(!ok){
+        printf("Sharded search failed: %s\n", sharded->error());
+        return;
+    }
+    printf("%d worker processes: %.0f queries/s\n", sharded->shards(), keys.size() / secs);
+    for( int s = 0; s < sharded->shards(); ++s)
+        printf("Shard %d (pid %d): keys %d to %d\n", s, (int)sharded->worker(s), sharded->fence(s).low, sharded->fence(s).high);
+    for( size_t q = 0; q < keys.size(); ++q)
+        if((bool)local[q] != out[q]){
+            printf("Results differ!\n");
+            break;
+        }
+}
+
+void test_shards(int dimension, int N, int shards, int queries){
+    mt19937 gen(1);
+    vector<int> keys(queries);
+    printf("----------------------------------------------------------------------\n\n");
+    if(dimension == 1){
+        vector<int> A(N);
+        LinearIncreasingDistribution(A.begin(), A.end(), 0, 1 << 28);
+        for( int q = 0; q < queries; ++q)
+            keys[q] = q % 2? A[gen() % N] : gen() % (1 << 28);
+        printf("N = %d, %d queries, binary search\n", N, queries);
+        compare_shards<int, 1>(A.begin(), A.end(), shards, [](auto f, auto l, int v){ return std::binary_search(f, l, v); }, keys);
+    }
+    else if(dimension == 2){
+        vector<vector<int> > A(N, vector<int>(N));
+        LinearIncreasingDistribution_2D(A.begin(), A.end(), 0, 1 << 20);
+        for( int q = 0; q < queries; ++q)
+            keys[q] = q % 2? A[gen() % N][gen() % N] : gen() % (1 << 20);
+        printf("N x N = %d x %d, %d queries, saddleback search\n", N, N, queries);
+        compare_shards<int, 2>(A.begin(), A.end(), shards, [](auto f, auto l, int v){ return saddleback_search(f, l, v); }, keys);
+    }
+    printf("----------------------------------------------------------------------\n\n");
+}
+
 /*!
  * \brief Function main.
  */
 int main(){
     int option;
     do{
-        printf("Test search algorithms for:\n1 - one-dimensional\n2 - two-dimensional\n3 - three-dimensional\nAnother value to leave:\n");
+        printf("Test search algorithms for:\n1 - one-dimensional\n2 - two-dimensional\n3 - three-dimensional\n4 - NUMA replication benchmark\n5 - Sharded search across processes\n6 - Calibrate the 2D/3D dispatcher and save it\nAnother value to leave:\n");
 
         scanf(" %d", &option);
         switch(option){
@@ -351,9 +541,42 @@ int main(){
                 test_D3(M, N, P, ld, min_value, interval);
                 break;
             }
+            case 4:{
+                int dimension, N, queries;
+                printf("Dimension (1, 2 or 3): ");
+                scanf(" %d", &dimension);
+                printf("Size of each dimension: ");
+                scanf(" %d", &N);
+                printf("How many queries: ");
+                scanf(" %d", &queries);
+                test_numa(dimension, N, queries);
+                break;
+            }
+            case 5:{
+                int dimension, N, shards, queries;
+                printf("Dimension (1 or 2): ");
+                scanf(" %d", &dimension);
+                printf("Size of each dimension: ");
+                scanf(" %d", &N);
+                printf("Worker processes: ");
+                scanf(" %d", &shards);
+                printf("How many queries: ");
+                scanf(" %d", &queries);
+                test_shards(dimension, N, shards, queries);
+                break;
+            }
+            case 6:{
+                dispatcher.calibrate();
+                if(dispatcher.save(CALIBRATION_FILE))
+                    printf("Calibration saved to %s\n", CALIBRATION_FILE);
+                else
+                    printf("Could not write %s\n", CALIBRATION_FILE);
+                printf("%s\n%s\n\n", dispatcher.explain_2D(512, 512).c_str(), dispatcher.explain_3D(64, 64, 64).c_str());
+                break;
+            }
             default:
                 break;
         }
-    }while(option > 0 && option  < 4);
+    }while(option > 0 && option  < 7);
     return 0;
 }
@@ -0,0 +1,163 @@
+/** \file MappedInstance.hpp
+ * Read-only, memory-mapped view of an instance file written by the WriteInstance functions.
+ */
+
+/*
+ *  MappedInstance.hpp
+ *
+ *  Instituto de Informatica - UFG
+ *
+ */
+
+#ifndef MappedInstance_hpp
+#define MappedInstance_hpp
+
+#include <cstddef>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "InstanceFormat.hpp"
+#include "InstanceView.hpp"
+
+/*!
+ * \brief Maps a D-dimensional instance file of element type T.
+ *
+ * Opening is an mmap call: the payload is used in place and pages are loaded on demand.
+ * view(), begin() and end() can be passed to every search template, e.g.
+ * MAHL_e(inst.begin(), inst.end(), key) or MAHL_e(inst.view(), key).
+ */
+template<class T, std::size_t D>
+class MappedInstance{
+public:
+    typedef StridedView<const T, D> view_type;
+    typedef typename view_type::iterator iterator;
+
+    MappedInstance() : base(0), length(0), msg(0){
+        std::memset(&hdr, 0, sizeof(hdr));
+    }
+
+    /*!
+     * \brief Maps a file; check is_open() or error() afterwards.
+     * \param filename path of the instance file.
+     */
+    explicit MappedInstance(const char* filename) : base(0), length(0), msg(0){
+        std::memset(&hdr, 0, sizeof(hdr));
+        open(filename);
+    }
+
+    ~MappedInstance(){
+        close();
+    }
+
+    MappedInstance(const MappedInstance&) = delete;
+    MappedInstance& operator=(const MappedInstance&) = delete;
+
+    MappedInstance(MappedInstance&& o) : base(o.base), length(o.length), hdr(o.hdr), vw(o.vw), msg(o.msg){
+        o.base = 0;
+        o.length = 0;
+    }
+
+    MappedInstance& operator=(MappedInstance&& o){
+        if(this != &o){
+            close();
+            base = o.base;
+            length = o.length;
+            hdr = o.hdr;
+            vw = o.vw;
+            msg = o.msg;
+            o.base = 0;
+            o.length = 0;
+        }
+        return *this;
+    }
+
+    /*!
+     * \brief Maps a file.
+     * \param filename path of the instance file.
+     * \return true if the file was mapped and matches T and D.
+     */
+    bool open(const char* filename){
+        close();
+        int fd = ::open(filename, O_RDONLY);
+        if(fd < 0){
+            msg = "cannot open instance file";
+            return false;
+        }
+        struct stat st;
+        if(fstat(fd, &st) != 0 || (std::uint64_t)st.st_size < sizeof(InstanceHeader)){
+            ::close(fd);
+            msg = "truncated instance file";
+            return false;
+        }
+        void* p = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if(p == MAP_FAILED){
+            msg = "mmap failed";
+            return false;
+        }
+        base = p;
+        length = st.st_size;
+        std::memcpy(&hdr, base, sizeof(hdr));
+        msg = CheckInstanceHeader(hdr, length);
+        if(!msg && (hdr.type != InstanceTypeCode<T>::value || hdr.element_size != sizeof(T)))
+            msg = "element type does not match";
+        if(!msg && hdr.dims != D)
+            msg = "number of dimensions does not match";
+        if(msg){
+            unmap();
+            return false;
+        }
+        typename view_type::index_type ext;
+        for( std::size_t d = 0; d < D; ++d)
+            ext[d] = hdr.extents[d];
+        vw = view_type((const T*)((const char*)base + hdr.payload_offset), ext);
+        return true;
+    }
+
+    /*!
+     * \brief Unmaps the file.
+     */
+    void close(){
+        unmap();
+        msg = 0;
+    }
+
+    /*!
+     * \brief Hints the kernel about the access pattern (MADV_RANDOM for searches, MADV_WILLNEED to prefetch).
+     */
+    bool advise(int advice) const{
+        return base && madvise(base, length, advice) == 0;
+    }
+
+    bool is_open() const{ return base != 0; }
+    const char* error() const{ return msg; }
+    const InstanceHeader& header() const{ return hdr; }
+    bool sorted() const{ return (hdr.flags & INSTANCE_SORTED) != 0; }
+
+    const view_type& view() const{ return vw; }
+    const T* data() const{ return vw.data(); }
+    std::ptrdiff_t extent(std::size_t d) const{ return vw.extent(d); }
+    iterator begin() const{ return vw.begin(); }
+    iterator end() const{ return vw.end(); }
+
+private:
+    void unmap(){
+        if(base)
+            munmap(base, length);
+        base = 0;
+        length = 0;
+        vw = view_type();
+    }
+
+    void* base;
+    std::uint64_t length;
+    InstanceHeader hdr;
+    view_type vw;
+    const char* msg;
+};
+
+#endif
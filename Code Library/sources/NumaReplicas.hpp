@@ -0,0 +1,287 @@
+/** \file NumaReplicas.hpp
+ * Per-NUMA-node copies of a read-only instance and a query engine that routes queries to local copies.
+ */
+
+/*
+ *  NumaReplicas.hpp
+ *
+ *  Instituto de Informatica - UFG
+ *
+ */
+
+/*
+ * On a machine with several sockets every probe of a search that lands on memory of another node pays
+ * the remote latency. NumaReplicas copies an instance once per node, each copy bound to its node with
+ * HugePageAllocator (and on huge pages), so the instance costs nodes times its size in memory.
+ * NumaQueryEngine runs one QueryEngine per node, with its workers pinned to the CPUs of that node and
+ * searching the copy of that node, so every probe reads local memory. Batches are spread over the nodes
+ * round robin, or sent to an explicit node. As in QueryEngine, the queues are single-producer: batches
+ * must be submitted by one thread at a time.
+ *
+ * Without replication (or on a machine with one node) there is a single copy, interleaved over the
+ * nodes, searched by one engine with a worker per CPU: the usual placement, kept as the baseline.
+ */
+
+#ifndef NumaReplicas_hpp
+#define NumaReplicas_hpp
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include "GeneratorInstance.hpp"
+#include "HugePageAllocator.hpp"
+#include "InstanceView.hpp"
+#include "QueryEngine.hpp"
+
+/*!
+ * \brief CPUs of a NUMA node, read from sysfs; empty if the node has no CPU list.
+ */
+inline std::vector<int> numa_node_cpus(int node){
+    std::vector<int> cpus;
+#ifdef __linux__
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    FILE* f = fopen(path, "r");
+    if(!f)
+        return cpus;
+    int a, b;
+    char sep = ',';
+    while(sep == ',' && fscanf(f, "%d", &a) == 1){
+        b = a;
+        if(fscanf(f, "%c", &sep) != 1)
+            sep = '\n';
+        if(sep == '-'){
+            if(fscanf(f, "%d", &b) != 1)
+                break;
+            if(fscanf(f, "%c", &sep) != 1)
+                sep = '\n';
+        }
+        for( int c = a; c <= b; ++c)
+            cpus.push_back(c);
+    }
+    fclose(f);
+#else
+    (void)node;
+#endif
+    return cpus;
+}
+
+/*!
+ * \brief NUMA node of the CPU that runs the calling thread (0 if unknown).
+ */
+inline int current_numa_node(){
+#ifdef __linux__
+    /* Node of every CPU, read once. */
+    static const std::vector<int> node_of = [](){
+        std::vector<int> map;
+        for( int n = 0; n < numa_nodes(); ++n){
+            std::vector<int> cpus = numa_node_cpus(n);
+            for( std::size_t c = 0; c < cpus.size(); ++c){
+                if(cpus[c] >= (int)map.size())
+                    map.resize(cpus[c] + 1, 0);
+                map[cpus[c]] = n;
+            }
+        }
+        return map;
+    }();
+    int cpu = sched_getcpu();
+    if(cpu >= 0 && cpu < (int)node_of.size())
+        return node_of[cpu];
+#endif
+    return 0;
+}
+
+/*!
+ * \brief Copies a D-dimensional source (first[i][j]...) to a view of the same extents.
+ */
+template<std::size_t D, class View, class Source>
+void replica_copy(View dst, const Source& src){
+    for( std::ptrdiff_t i = 0; i < dst.size(); ++i){
+        if constexpr (D == 1)
+            dst[i] = src[i];
+        else
+            replica_copy<D-1>(dst[i], src[i]);
+    }
+}
+
+/*!
+ * \brief Extents of a D-dimensional source given by first and last.
+ */
+template<std::size_t D, class ForwardIt>
+std::array<std::ptrdiff_t, D> replica_extents(ForwardIt first, ForwardIt last){
+    std::array<std::ptrdiff_t, D> ext;
+    ext.fill(0);
+    ext[0] = last - first;
+    if constexpr (D >= 2){
+        if(ext[0] > 0)
+            ext[1] = first[0].size();
+    }
+    if constexpr (D >= 3){
+        if(ext[1] > 0)
+            ext[2] = first[0][0].size();
+    }
+    return ext;
+}
+
+/*!
+ * \brief Read-only D-dimensional instance (D = 1, 2 or 3) copied once per NUMA node.
+ */
+template<class T, std::size_t D>
+class NumaReplicas{
+    static_assert(D >= 1 && D <= 3, "NumaReplicas supports one to three dimensions");
+public:
+    typedef StridedView<const T, D> view_type;
+    typedef typename view_type::iterator iterator;
+
+    /*!
+     * \param first iterator to start of array.
+     * \param last iterator to end of array.
+     * \param replicate one copy per node; false for a single copy interleaved over the nodes.
+     * \param pages page size of the copies.
+     */
+    template<class ForwardIt>
+    NumaReplicas(ForwardIt first, ForwardIt last, bool replicate = true, PageKind pages = PAGES_THP){
+        int nodes = replicate? numa_nodes() : 1;
+        copies = replicate;
+        typename view_type::index_type ext = replica_extents<D>(first, last);
+        for( int n = 0; n < nodes; ++n){
+            PagePolicy policy(pages, replicate? NUMA_NODE : NUMA_INTERLEAVE, n);
+            replicas.push_back(std::unique_ptr<HugeDenseArray<T, D> >(new HugeDenseArray<T, D>(ext, policy)));
+        }
+        /* The pages are already bound to their nodes, so the copies can be made by any thread. */
+        ParallelFor(nodes, 0, [&](std::int64_t n){
+            replica_copy<D>(replicas[n]->view(), first);
+        });
+    }
+
+    NumaReplicas(const NumaReplicas&) = delete;
+    NumaReplicas& operator=(const NumaReplicas&) = delete;
+
+    /*!
+     * \brief Number of copies.
+     */
+    int nodes() const{ return replicas.size(); }
+
+    /*!
+     * \brief True if there is one copy per node.
+     */
+    bool replicated() const{ return copies; }
+
+    view_type view(int node) const{ return view_type(replicas[node]->data(), replicas[node]->extents()); }
+    iterator begin(int node) const{ return view(node).begin(); }
+    iterator end(int node) const{ return view(node).end(); }
+
+    /*!
+     * \brief Bytes used by every copy together.
+     */
+    std::size_t memory() const{ return replicas.size() * (std::size_t)view(0).count() * sizeof(T); }
+
+    /*!
+     * \brief Prints the page sizes and NUMA nodes of every copy.
+     */
+    void report(FILE* out) const{
+        for( int n = 0; n < nodes(); ++n){
+            fprintf(out, "Copy %d: ", n);
+            PagePlacement r = page_placement(view(n).data(), view(n).count() * sizeof(T));
+            fprintf(out, "%.1f MB on huge pages; sampled pages per node:", r.huge_bytes / 1048576.);
+            for( std::size_t k = 0; k < r.node_pages.size(); ++k)
+                fprintf(out, " %zu", r.node_pages[k]);
+            fprintf(out, "\n");
+        }
+    }
+
+private:
+    std::vector<std::unique_ptr<HugeDenseArray<T, D> > > replicas;
+    bool copies;
+};
+
+
+/*!
+ * \brief Query engine over NumaReplicas that searches each batch on the copy of the node that runs it.
+ *
+ * search(first, last, key) is any of the library searches, e.g.
+ * [](auto f, auto l, int v){ return MAHL_e(f, l, v); }.
+ *
+ * Batches must be submitted (submit and run) by one thread at a time, which feeds every node; any thread
+ * may wait for a batch.
+ */
+template<class T, std::size_t D, class Search>
+class NumaQueryEngine{
+public:
+    typedef typename NumaReplicas<T, D>::iterator iterator;
+    typedef QueryEngine<iterator, T, Search> engine_type;
+
+    /*!
+     * \param replicas copies of the instance; must outlive the engine.
+     * \param search search function.
+     * \param threads workers per node (0 for one per CPU of the node).
+     * \param pin pin the workers to the CPUs of their node.
+     */
+    NumaQueryEngine(const NumaReplicas<T, D>& replicas, Search search, unsigned threads = 0, bool pin = true) : next(0){
+        for( int n = 0; n < replicas.nodes(); ++n){
+            std::vector<int> cpus;
+            if(replicas.replicated())
+                cpus = numa_node_cpus(n);
+            engines.push_back(std::unique_ptr<engine_type>(new engine_type(replicas.begin(n), replicas.end(n), search, threads, pin, cpus)));
+        }
+    }
+
+    /*!
+     * \brief Queues a batch on the next node, round robin.
+     */
+    void submit(QueryBatch<T>* batch){
+        submit(next, batch);
+        next = next + 1 == (int)engines.size()? 0 : next + 1;
+    }
+
+    /*!
+     * \brief Queues a batch on a node.
+     */
+    void submit(int node, QueryBatch<T>* batch){
+        engines[node % engines.size()]->submit(batch);
+    }
+
+    /*!
+     * \brief Searches count keys, split in batches over every node, and waits for the results.
+     */
+    void run(const T* keys, std::size_t count, bool* results){
+        std::size_t batches = (count + ENGINE_BATCH - 1) / ENGINE_BATCH;
+        std::unique_ptr<QueryBatch<T>[]> b(new QueryBatch<T>[batches]);
+        for( std::size_t i = 0; i < batches; ++i){
+            std::size_t lo = i * ENGINE_BATCH, n = std::min<std::size_t>(ENGINE_BATCH, count - lo);
+            b[i].keys = keys + lo;
+            b[i].count = n;
+            b[i].results = results + lo;
+            submit(&b[i]);
+        }
+        for( std::size_t i = 0; i < batches; ++i)
+            b[i].wait();
+    }
+
+    int nodes() const{ return engines.size(); }
+    const engine_type& engine(int node) const{ return *engines[node]; }
+
+private:
+    std::vector<std::unique_ptr<engine_type> > engines;
+    int next;
+};
+
+/*!
+ * \brief Builds a NumaQueryEngine.
+ */
+template<class T, std::size_t D, class Search>
+std::unique_ptr<NumaQueryEngine<T, D, Search> > make_numa_query_engine(const NumaReplicas<T, D>& replicas, Search search,
+                                                                        unsigned threads = 0, bool pin = true){
+    return std::unique_ptr<NumaQueryEngine<T, D, Search> >(new NumaQueryEngine<T, D, Search>(replicas, search, threads, pin));
+}
+
+#endif
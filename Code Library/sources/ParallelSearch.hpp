@@ -0,0 +1,103 @@
+/** \file ParallelSearch.hpp
+ * Multi-threaded linear scans with early exit, for large unsorted arrays.
+ */
+
+/*
+ *  ParallelSearch.hpp
+ *
+ *  Instituto de Informatica - UFG
+ *
+ */
+
+/*
+ * The array is split in chunks of PARALLEL_SCAN_CHUNK elements that the threads claim in increasing order.
+ * Inside a chunk, blocks of PARALLEL_SCAN_BLOCK elements are compared without branches, so the compiler
+ * can vectorize them, and only a block with a match is scanned again for its position. gcc only runs the
+ * loop vectorizer from -O2 on, which is why the makefile builds with it (a scan is twice as slow at -O).
+ *
+ * "Any" semantics: the first thread that finds the key raises a shared flag and the others stop at their
+ * next block. "First" semantics: the smallest position found so far is kept in a shared atomic; chunks
+ * that start after it are skipped, while the chunks before it are still scanned, so the result is the
+ * first occurrence in the array whatever the number of threads.
+ */
+
+#ifndef ParallelSearch_hpp
+#define ParallelSearch_hpp
+
+#include <atomic>
+#include <cstdint>
+
+#include "GeneratorInstance.hpp"
+
+#define PARALLEL_SCAN_CHUNK (1 << 16)
+#define PARALLEL_SCAN_BLOCK 64
+
+/*!
+ * \brief Position of the first element equal to value in [lo, hi), or hi; stops early when stop() is true.
+ */
+template<class ForwardIt, class T, class Stop>
+std::int64_t scan_block(ForwardIt first, std::int64_t lo, std::int64_t hi, const T& value, Stop stop){
+    std::int64_t i = lo;
+    for( ; i + PARALLEL_SCAN_BLOCK <= hi; i += PARALLEL_SCAN_BLOCK){
+        if(stop())
+            return hi;
+        unsigned hit = 0;
+        for( int b = 0; b < PARALLEL_SCAN_BLOCK; ++b)
+            hit |= first[i+b] == value;
+        if(hit)
+            break;
+    }
+    for( ; i < hi; ++i)
+        if(first[i] == value)
+            return i;
+    return hi;
+}
+
+/*!
+ * \brief Parallel linear search function ("any" semantics).
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ * \param threads number of threads (0 for one per hardware thread).
+ */
+template<class ForwardIt, class T>
+bool parallel_linear_search(ForwardIt first, ForwardIt last, const T& value, unsigned threads = 0){
+    std::int64_t n = last - first;
+    std::atomic<bool> found(false);
+    ParallelFor((n + PARALLEL_SCAN_CHUNK - 1) / PARALLEL_SCAN_CHUNK, threads, [&](std::int64_t c){
+        if(found.load(std::memory_order_relaxed))
+            return;
+        std::int64_t lo = c * PARALLEL_SCAN_CHUNK, hi = std::min<std::int64_t>(lo + PARALLEL_SCAN_CHUNK, n);
+        if(scan_block(first, lo, hi, value, [&](){ return found.load(std::memory_order_relaxed); }) < hi)
+            found.store(true, std::memory_order_relaxed);
+    });
+    return found;
+}
+
+/*!
+ * \brief Parallel linear search function ("first position" semantics).
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ * \param threads number of threads (0 for one per hardware thread).
+ * \return position of the first element equal to value, or the size of the array if there is none.
+ */
+template<class ForwardIt, class T>
+std::int64_t parallel_linear_find(ForwardIt first, ForwardIt last, const T& value, unsigned threads = 0){
+    std::int64_t n = last - first;
+    std::atomic<std::int64_t> best(n);
+    ParallelFor((n + PARALLEL_SCAN_CHUNK - 1) / PARALLEL_SCAN_CHUNK, threads, [&](std::int64_t c){
+        std::int64_t lo = c * PARALLEL_SCAN_CHUNK, hi = std::min<std::int64_t>(lo + PARALLEL_SCAN_CHUNK, n);
+        if(lo >= best.load(std::memory_order_relaxed))
+            return;
+        std::int64_t p = scan_block(first, lo, hi, value, [&](){ return best.load(std::memory_order_relaxed) < lo; });
+        if(p < hi){
+            std::int64_t b = best.load(std::memory_order_relaxed);
+            while(p < b && !best.compare_exchange_weak(b, p, std::memory_order_relaxed))
+                ;
+        }
+    });
+    return best;
+}
+
+#endif
@@ -0,0 +1,252 @@
+/** \file QueryEngine.hpp
+ * Pool of pinned worker threads that run batches of searches over one read-only instance.
+ */
+
+/*
+ *  QueryEngine.hpp
+ *
+ *  Instituto de Informatica - UFG
+ *
+ */
+
+/*
+ * Every worker owns a bounded single-producer single-consumer queue of batches. A batch points to the
+ * keys and to a result buffer that only its worker writes, and is marked done with a release store, so
+ * the hot path has no locks and no writes shared between workers. Queue indexes, batches and workers
+ * are aligned to cache lines to avoid false sharing.
+ *
+ * Batches must be submitted by one thread at a time (the producer side of the queues); any thread may
+ * wait for a batch.
+ */
+
+#ifndef QueryEngine_hpp
+#define QueryEngine_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#define ENGINE_QUEUE_CAPACITY 1024 /* Batches per worker queue; a power of two. */
+#define ENGINE_BATCH 256           /* Keys per batch in QueryEngine::run. */
+
+/*!
+ * \brief Bounded lock-free queue for one producer and one consumer thread.
+ */
+template<class T>
+class SPSCQueue{
+public:
+    /*!
+     * \param capacity number of slots, rounded up to a power of two.
+     */
+    explicit SPSCQueue(std::size_t capacity = ENGINE_QUEUE_CAPACITY) : head(0), tail(0){
+        std::size_t c = 2;
+        while(c < capacity)
+            c <<= 1;
+        slots.resize(c);
+        mask = c - 1;
+    }
+
+    bool try_push(const T& item){
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        if(t - head.load(std::memory_order_acquire) > mask)
+            return false;
+        slots[t & mask] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T& item){
+        std::size_t h = head.load(std::memory_order_relaxed);
+        if(h == tail.load(std::memory_order_acquire))
+            return false;
+        item = slots[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    alignas(64) std::atomic<std::size_t> head; /* Written by the consumer. */
+    alignas(64) std::atomic<std::size_t> tail; /* Written by the producer. */
+    alignas(64) std::vector<T> slots;
+    std::size_t mask;
+};
+
+/*!
+ * \brief Keys to search and the buffer that receives their results.
+ */
+template<class T>
+struct alignas(64) QueryBatch{
+    const T* keys;
+    std::size_t count;
+    bool* results;
+    std::atomic<bool> done;
+
+    QueryBatch(const T* keys = 0, std::size_t count = 0, bool* results = 0) : keys(keys), count(count), results(results), done(false){}
+
+    /*!
+     * \brief Waits until the worker has written every result.
+     */
+    void wait() const{
+        for( int spin = 0; !done.load(std::memory_order_acquire); ++spin)
+            if(spin > 64)
+                std::this_thread::yield();
+    }
+};
+
+/*!
+ * \brief Worker pool bound to one instance and one search function.
+ *
+ * search(first, last, key) is any of the library searches, e.g.
+ * [](It f, It l, int v){ return MAHL_e(f, l, v); }.
+ */
+template<class ForwardIt, class T, class Search>
+class QueryEngine{
+public:
+    /*!
+     * \param first iterator to start of array.
+     * \param last iterator to end of array.
+     * \param search search function.
+     * \param threads number of workers (0 for one per hardware thread, or one per CPU of cpus).
+     * \param pin pin worker w to CPU w modulo the number of CPUs.
+     * \param cpus CPUs to pin the workers to, in turn; empty for every CPU.
+     */
+    QueryEngine(ForwardIt first, ForwardIt last, Search search, unsigned threads = 0, bool pin = true,
+                const std::vector<int>& cpus = std::vector<int>())
+        : first(first), last(last), search(search), next(0){
+        if(threads == 0)
+            threads = cpus.empty()? std::thread::hardware_concurrency() : cpus.size();
+        if(threads == 0)
+            threads = 1;
+        workers.reserve(threads);
+        for( unsigned w = 0; w < threads; ++w)
+            workers.push_back(std::unique_ptr<Worker>(new Worker()));
+        for( unsigned w = 0; w < threads; ++w){
+            workers[w]->thread = std::thread(&QueryEngine::work, this, w);
+            if(pin)
+                pin_thread(workers[w]->thread, cpus.empty()? (int)w : cpus[w % cpus.size()]);
+        }
+    }
+
+    ~QueryEngine(){
+        for( std::size_t w = 0; w < workers.size(); ++w)
+            workers[w]->stop.store(true, std::memory_order_release);
+        for( std::size_t w = 0; w < workers.size(); ++w)
+            workers[w]->thread.join();
+    }
+
+    QueryEngine(const QueryEngine&) = delete;
+    QueryEngine& operator=(const QueryEngine&) = delete;
+
+    /*!
+     * \brief Queues a batch on the next worker, round robin. Waits while that queue is full.
+     */
+    void submit(QueryBatch<T>* batch){
+        submit(next, batch);
+        next = next + 1 == workers.size()? 0 : next + 1;
+    }
+
+    /*!
+     * \brief Queues a batch on worker w. Waits while its queue is full.
+     */
+    void submit(std::size_t w, QueryBatch<T>* batch){
+        batch->done.store(false, std::memory_order_relaxed);
+        while(!workers[w]->queue.try_push(batch))
+            std::this_thread::yield();
+    }
+
+    /*!
+     * \brief Searches count keys, split in batches over every worker, and waits for the results.
+     */
+    void run(const T* keys, std::size_t count, bool* results){
+        std::size_t batches = (count + ENGINE_BATCH - 1) / ENGINE_BATCH;
+        std::unique_ptr<QueryBatch<T>[]> b(new QueryBatch<T>[batches]);
+        for( std::size_t i = 0; i < batches; ++i){
+            std::size_t lo = i * ENGINE_BATCH, n = std::min<std::size_t>(ENGINE_BATCH, count - lo);
+            b[i].keys = keys + lo;
+            b[i].count = n;
+            b[i].results = results + lo;
+            submit(&b[i]);
+        }
+        for( std::size_t i = 0; i < batches; ++i)
+            b[i].wait();
+    }
+
+    std::size_t threads() const{ return workers.size(); }
+
+    /*!
+     * \brief Keys searched by worker w.
+     */
+    std::size_t searched(std::size_t w) const{ return workers[w]->keys.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(64) Worker{
+        SPSCQueue<QueryBatch<T>*> queue;
+        std::atomic<bool> stop;
+        std::atomic<std::size_t> keys;
+        std::thread thread;
+        Worker() : stop(false), keys(0){}
+    };
+
+    void work(unsigned w){
+        Worker& self = *workers[w];
+        QueryBatch<T>* batch;
+        int idle = 0;
+        for( ; ; ){
+            if(self.queue.try_pop(batch)){
+                for( std::size_t i = 0; i < batch->count; ++i)
+                    batch->results[i] = search(first, last, batch->keys[i]);
+                self.keys.store(self.keys.load(std::memory_order_relaxed) + batch->count, std::memory_order_relaxed);
+                batch->done.store(true, std::memory_order_release);
+                idle = 0;
+                continue;
+            }
+            if(self.stop.load(std::memory_order_acquire))
+                return;
+            /* Spin briefly, then yield, then sleep while there is no work. */
+            if(++idle > 1024)
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            else if(idle > 64)
+                std::this_thread::yield();
+        }
+    }
+
+    static void pin_thread(std::thread& t, int cpu){
+#ifdef __linux__
+        unsigned cpus = std::thread::hardware_concurrency();
+        if(cpus == 0)
+            return;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu % cpus, &set);
+        pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
+#else
+        (void)t;
+        (void)cpu;
+#endif
+    }
+
+    ForwardIt first, last;
+    Search search;
+    std::size_t next;
+    std::vector<std::unique_ptr<Worker> > workers;
+};
+
+/*!
+ * \brief Builds a QueryEngine for keys of type T.
+ */
+template<class T, class ForwardIt, class Search>
+std::unique_ptr<QueryEngine<ForwardIt, T, Search> > make_query_engine(ForwardIt first, ForwardIt last, Search search,
+                                                                      unsigned threads = 0, bool pin = true){
+    return std::unique_ptr<QueryEngine<ForwardIt, T, Search> >(new QueryEngine<ForwardIt, T, Search>(first, last, search, threads, pin));
+}
+
+#endif
@@ -0,0 +1,190 @@
+/** \file RangeQueries.hpp
+ * Counting and reporting of the elements in a value range of two- and three-dimensional sorted arrays.
+ */
+
+/*
+ *  RangeQueries.hpp
+ *
+ *  Instituto de Informatica - UFG
+ *
+ */
+
+/*
+ * In a matrix sorted along rows and columns, the elements of row i less than x are a prefix of the row,
+ * and its length can only shrink from one row to the next. A staircase walk that moves the end of that
+ * prefix left while going down the rows finds all of them in O(m+n). Two walks, one for lo and one for hi,
+ * give the interval of every row with lo <= value <= hi: counting is O(m+n) and reporting O(m+n+k) for
+ * k results. Three-dimensional arrays are handled as layers of such matrices, in O(m(n+p)) and
+ * O(m(n+p)+k); layers whose corners fall outside the range are skipped.
+ *
+ * The threads argument splits rows (2D) or layers (3D) among threads; 1 runs in the calling thread and
+ * 0 uses one thread per hardware thread. With more than one thread, visit is called concurrently for
+ * different rows or layers.
+ */
+
+#ifndef RangeQueries_hpp
+#define RangeQueries_hpp
+
+#include <atomic>
+#include <cstdint>
+
+#include "GeneratorInstance.hpp"
+
+#define RANGE_ROWS_PER_TASK 256 /* Rows of a 2D matrix handled by one parallel task. */
+
+/*!
+ * \brief Reports the elements of rows [r0, r1) of a sorted matrix with lo <= value <= hi.
+ * \param a matrix, indexed as a[i][j].
+ * \param r0 first row.
+ * \param r1 row after the last one.
+ * \param n number of columns.
+ * \param lo lower bound of the range.
+ * \param hi upper bound of the range.
+ * \param visit function called as visit(i, j) for every element, or 0 to only count.
+ * \return number of elements in the range.
+ */
+template<class Matrix, class T, class Visit>
+std::int64_t range_rows(Matrix&& a, int r0, int r1, int n, const T& lo, const T& hi, Visit* visit){
+    std::int64_t count = 0;
+    int jl = n, jh = n; /* Elements of row i less than lo, and not greater than hi. */
+    for( int i = r0; i < r1; ++i){
+        while(jh > 0 && hi < a[i][jh-1])
+            --jh;
+        if(jh == 0)
+            break;
+        while(jl > 0 && !(a[i][jl-1] < lo))
+            --jl;
+        count += jh - jl;
+        if(visit)
+            for( int j = jl; j < jh; ++j)
+                (*visit)(i, j);
+    }
+    return count;
+}
+
+/*!
+ * \brief Counts the elements with lo <= value <= hi of a two-dimensional sorted array.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param lo lower bound of the range.
+ * \param hi upper bound of the range.
+ * \param threads number of threads.
+ */
+template<class ForwardIt, class T>
+std::int64_t range_count_2D(ForwardIt first, ForwardIt last, const T& lo, const T& hi, unsigned threads = 1){
+    int (*none)(int, int) = 0;
+    int m = last - first, n = m > 0? first[0].size() : 0;
+    if(m == 0 || n == 0 || hi < lo)
+        return 0;
+    std::atomic<std::int64_t> count(0);
+    ParallelFor((m + RANGE_ROWS_PER_TASK - 1) / RANGE_ROWS_PER_TASK, threads, [&](std::int64_t t){
+        int r0 = t * RANGE_ROWS_PER_TASK, r1 = std::min(m, r0 + RANGE_ROWS_PER_TASK);
+        count += range_rows(first, r0, r1, n, lo, hi, none);
+    });
+    return count;
+}
+
+/*!
+ * \brief Reports the elements with lo <= value <= hi of a two-dimensional sorted array.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param lo lower bound of the range.
+ * \param hi upper bound of the range.
+ * \param visit function called as visit(i, j) for every element.
+ * \param threads number of threads.
+ * \return number of elements reported.
+ */
+template<class ForwardIt, class T, class Visit>
+std::int64_t range_report_2D(ForwardIt first, ForwardIt last, const T& lo, const T& hi, Visit visit, unsigned threads = 1){
+    int m = last - first, n = m > 0? first[0].size() : 0;
+    if(m == 0 || n == 0 || hi < lo)
+        return 0;
+    std::atomic<std::int64_t> count(0);
+    ParallelFor((m + RANGE_ROWS_PER_TASK - 1) / RANGE_ROWS_PER_TASK, threads, [&](std::int64_t t){
+        int r0 = t * RANGE_ROWS_PER_TASK, r1 = std::min(m, r0 + RANGE_ROWS_PER_TASK);
+        count += range_rows(first, r0, r1, n, lo, hi, &visit);
+    });
+    return count;
+}
+
+/*!
+ * \brief Layer of a three-dimensional array seen as a matrix, with its visits tagged with the layer index.
+ */
+template<class Visit>
+struct RangeLayerVisit{
+    Visit* visit;
+    int i;
+    void operator()(int j, int k) const{ (*visit)(i, j, k); }
+};
+
+/*!
+ * \brief Counts the elements with lo <= value <= hi of a three-dimensional sorted array.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param lo lower bound of the range.
+ * \param hi upper bound of the range.
+ * \param threads number of threads.
+ */
+template<class ForwardIt, class T>
+std::int64_t range_count_3D(ForwardIt first, ForwardIt last, const T& lo, const T& hi, unsigned threads = 1){
+    int (*none)(int, int) = 0;
+    int m = last - first, n = m > 0? first[0].size() : 0, p = n > 0? first[0][0].size() : 0;
+    if(m == 0 || n == 0 || p == 0 || hi < lo)
+        return 0;
+    std::atomic<std::int64_t> count(0);
+    ParallelFor(m, threads, [&](std::int64_t i){
+        if(hi < first[i][0][0] || first[i][n-1][p-1] < lo)
+            return;
+        count += range_rows(first[i], 0, n, p, lo, hi, none);
+    });
+    return count;
+}
+
+/*!
+ * \brief Reports the elements with lo <= value <= hi of a three-dimensional sorted array.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param lo lower bound of the range.
+ * \param hi upper bound of the range.
+ * \param visit function called as visit(i, j, k) for every element.
+ * \param threads number of threads.
+ * \return number of elements reported.
+ */
+template<class ForwardIt, class T, class Visit>
+std::int64_t range_report_3D(ForwardIt first, ForwardIt last, const T& lo, const T& hi, Visit visit, unsigned threads = 1){
+    int m = last - first, n = m > 0? first[0].size() : 0, p = n > 0? first[0][0].size() : 0;
+    if(m == 0 || n == 0 || p == 0 || hi < lo)
+        return 0;
+    std::atomic<std::int64_t> count(0);
+    ParallelFor(m, threads, [&](std::int64_t i){
+        if(hi < first[i][0][0] || first[i][n-1][p-1] < lo)
+            return;
+        RangeLayerVisit<Visit> layer = {&visit, (int)i};
+        count += range_rows(first[i], 0, n, p, lo, hi, &layer);
+    });
+    return count;
+}
+
+/*!
+ * \brief Number of occurrences of value in a two-dimensional sorted array.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ */
+template<class ForwardIt, class T>
+std::int64_t count_2D(ForwardIt first, ForwardIt last, const T& value){
+    return range_count_2D(first, last, value, value);
+}
+
+/*!
+ * \brief Number of occurrences of value in a three-dimensional sorted array.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ */
+template<class ForwardIt, class T>
+std::int64_t count_3D(ForwardIt first, ForwardIt last, const T& value){
+    return range_count_3D(first, last, value, value);
+}
+
+#endif
@@ -0,0 +1,317 @@
+/** \file ResultCache.hpp
+ * Concurrent cache of search results for skewed query distributions.
+ */
+
+/*
+ *  ResultCache.hpp
+ *
+ *  Instituto de Informatica - UFG
+ *
+ */
+
+/*
+ * The cache is split in shards selected by the hash of the key, each one with its own lock, so threads
+ * searching different keys rarely wait for each other. Every shard is a CLOCK ring: a hit sets the
+ * reference bit of its slot, and a replacement clears reference bits until it finds a slot without one.
+ * With TinyLFU admission a new key only replaces the CLOCK victim when a count-min sketch of recent
+ * accesses says it is more frequent, so one-off keys do not flush the hot set.
+ *
+ * Entries are tagged with the epoch in which they were computed. invalidate() starts a new epoch, and
+ * entries of older epochs are then misses; a result computed while the instance was being replaced is
+ * stored with the old epoch and is never returned.
+ */
+
+#ifndef ResultCache_hpp
+#define ResultCache_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#define CACHE_SKETCH_ROWS 4
+
+/*!
+ * \brief Sharded CLOCK cache from keys to results, with optional TinyLFU admission.
+ */
+template<class K, class V = bool>
+class ResultCache{
+public:
+    /*!
+     * \param capacity total number of cached keys.
+     * \param shards number of independently locked shards.
+     * \param tinylfu use TinyLFU admission.
+     */
+    ResultCache(std::size_t capacity, unsigned shards = 16, bool tinylfu = false) : epoch(1){
+        nshards = shards < 1? 1 : shards;
+        std::size_t per = (capacity + nshards - 1) / nshards;
+        shard.reset(new Shard[nshards]);
+        for( unsigned s = 0; s < nshards; ++s)
+            shard[s].init(per < 1? 1 : per, tinylfu);
+    }
+
+    /*!
+     * \brief Looks a key up.
+     * \param key search key.
+     * \param out result, set on a hit.
+     * \return true on a hit.
+     */
+    bool lookup(const K& key, V& out){
+        std::uint64_t h = hash(key);
+        Shard& s = shard[h % nshards];
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.record(h);
+        typename std::unordered_map<K, std::size_t>::iterator it = s.index.find(key);
+        if(it != s.index.end()){
+            Slot& e = s.slots[it->second];
+            if(e.epoch == epoch.load(std::memory_order_acquire)){
+                e.ref = true;
+                out = e.value;
+                ++s.hits;
+                return true;
+            }
+        }
+        ++s.misses;
+        return false;
+    }
+
+    /*!
+     * \brief Stores the result of a key computed during epoch e.
+     */
+    void store(const K& key, const V& value, std::uint64_t e){
+        std::uint64_t h = hash(key);
+        Shard& s = shard[h % nshards];
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.insert(key, value, e, h, epoch.load(std::memory_order_acquire));
+    }
+
+    void store(const K& key, const V& value){
+        store(key, value, current_epoch());
+    }
+
+    /*!
+     * \brief Returns the cached result of key, or computes it with compute(key) and caches it.
+     */
+    template<class Compute>
+    V get(const K& key, Compute compute){
+        V value;
+        if(lookup(key, value))
+            return value;
+        std::uint64_t e = current_epoch();
+        value = compute(key);
+        store(key, value, e);
+        return value;
+    }
+
+    /*!
+     * \brief Drops every cached result. Must be called when the instance is modified or reloaded.
+     */
+    void invalidate(){ epoch.fetch_add(1, std::memory_order_acq_rel); }
+
+    std::uint64_t current_epoch() const{ return epoch.load(std::memory_order_acquire); }
+
+    std::uint64_t hits() const{ return sum(&Shard::hits); }
+    std::uint64_t misses() const{ return sum(&Shard::misses); }
+
+    /*!
+     * \brief Number of stores refused by the admission policy.
+     */
+    std::uint64_t rejected() const{ return sum(&Shard::rejected); }
+
+    double hit_rate() const{
+        std::uint64_t h = hits(), m = misses();
+        return h + m? (double)h / (h + m) : 0;
+    }
+
+    void reset_counters(){
+        for( unsigned s = 0; s < nshards; ++s){
+            std::lock_guard<std::mutex> lock(shard[s].mutex);
+            shard[s].hits = shard[s].misses = shard[s].rejected = 0;
+        }
+    }
+
+private:
+    struct Slot{
+        K key;
+        V value;
+        std::uint64_t epoch; /* 0 for an empty slot. */
+        bool ref;
+    };
+
+    struct alignas(64) Shard{
+        std::mutex mutex;
+        std::vector<Slot> slots;
+        std::unordered_map<K, std::size_t> index;
+        std::size_t hand;
+        std::uint64_t hits, misses, rejected;
+        /* TinyLFU count-min sketch; empty without admission. */
+        std::vector<std::uint8_t> sketch;
+        std::uint64_t sketch_mask, additions;
+
+        void init(std::size_t capacity, bool tinylfu){
+            slots.assign(capacity, Slot());
+            for( std::size_t i = 0; i < capacity; ++i){
+                slots[i].epoch = 0;
+                slots[i].ref = false;
+            }
+            index.reserve(capacity*2);
+            hand = 0;
+            hits = misses = rejected = additions = 0;
+            sketch_mask = 0;
+            if(tinylfu){
+                std::size_t width = 64;
+                while(width < capacity*8)
+                    width <<= 1;
+                sketch.assign(width*CACHE_SKETCH_ROWS, 0);
+                sketch_mask = width - 1;
+            }
+        }
+
+        std::size_t counter(std::uint64_t h, int row) const{
+            std::uint64_t x = (h + row) * 0x9e3779b97f4a7c15ULL;
+            return row*(sketch_mask+1) + ((x >> 32) & sketch_mask);
+        }
+
+        void record(std::uint64_t h){
+            if(sketch.empty())
+                return;
+            for( int r = 0; r < CACHE_SKETCH_ROWS; ++r){
+                std::uint8_t& c = sketch[counter(h, r)];
+                if(c < 15)
+                    ++c;
+            }
+            /* Aging: halve every counter after 10 accesses per slot. */
+            if(++additions >= slots.size()*10){
+                for( std::size_t i = 0; i < sketch.size(); ++i)
+                    sketch[i] >>= 1;
+                additions = 0;
+            }
+        }
+
+        int frequency(std::uint64_t h) const{
+            int f = 15;
+            for( int r = 0; r < CACHE_SKETCH_ROWS; ++r)
+                f = std::min<int>(f, sketch[counter(h, r)]);
+            return f;
+        }
+
+        void insert(const K& key, const V& value, std::uint64_t e, std::uint64_t h, std::uint64_t now){
+            typename std::unordered_map<K, std::size_t>::iterator it = index.find(key);
+            if(it != index.end()){
+                Slot& s = slots[it->second];
+                if(e >= s.epoch){
+                    s.value = value;
+                    s.epoch = e;
+                }
+                return;
+            }
+            /* CLOCK sweep; empty and stale slots are taken at once. */
+            std::size_t victim;
+            for( ; ; ){
+                Slot& s = slots[hand];
+                victim = hand;
+                hand = hand+1 == slots.size()? 0 : hand+1;
+                if(s.epoch != now || !s.ref)
+                    break;
+                s.ref = false;
+            }
+            Slot& s = slots[victim];
+            if(s.epoch == now && !sketch.empty() && frequency(h) <= frequency(ResultCache::hash(s.key))){
+                ++rejected;
+                return;
+            }
+            if(s.epoch != 0)
+                index.erase(s.key);
+            s.key = key;
+            s.value = value;
+            s.epoch = e;
+            s.ref = false;
+            index[key] = victim;
+        }
+    };
+
+    static std::uint64_t hash(const K& key){
+        std::uint64_t x = std::hash<K>()(key);
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    std::uint64_t sum(std::uint64_t Shard::*field) const{
+        std::uint64_t t = 0;
+        for( unsigned s = 0; s < nshards; ++s){
+            std::lock_guard<std::mutex> lock(shard[s].mutex);
+            t += shard[s].*field;
+        }
+        return t;
+    }
+
+    unsigned nshards;
+    std::unique_ptr<Shard[]> shard;
+    std::atomic<std::uint64_t> epoch;
+};
+
+
+/*!
+ * \brief Search function over an instance with a result cache in front of it.
+ *
+ * search(first, last, value) is any of the library searches, e.g.
+ * [](It f, It l, int v){ return MAHL_e(f, l, v); }.
+ */
+template<class ForwardIt, class T, class Search>
+class CachedSearch{
+public:
+    /*!
+     * \param first iterator to start of array.
+     * \param last iterator to end of array.
+     * \param search search function.
+     * \param capacity number of cached keys.
+     * \param shards number of cache shards.
+     * \param tinylfu use TinyLFU admission.
+     */
+    CachedSearch(ForwardIt first, ForwardIt last, Search search, std::size_t capacity, unsigned shards = 16, bool tinylfu = false)
+        : first(first), last(last), search(search), cache(capacity, shards, tinylfu){}
+
+    bool operator()(const T& value){
+        return cache.get(value, [this](const T& v){ return (bool)search(first, last, v); });
+    }
+
+    /*!
+     * \brief Drops the cached results after the instance was modified in place.
+     */
+    void invalidate(){ cache.invalidate(); }
+
+    /*!
+     * \brief Points the search to a reloaded instance and drops the cached results.
+     * Must not run concurrently with searches.
+     */
+    void reset(ForwardIt new_first, ForwardIt new_last){
+        first = new_first;
+        last = new_last;
+        cache.invalidate();
+    }
+
+    const ResultCache<T, bool>& results() const{ return cache; }
+    ResultCache<T, bool>& results(){ return cache; }
+
+private:
+    ForwardIt first, last;
+    Search search;
+    ResultCache<T, bool> cache;
+};
+
+/*!
+ * \brief Builds a CachedSearch for keys of type T.
+ */
+template<class T, class ForwardIt, class Search>
+CachedSearch<ForwardIt, T, Search> make_cached_search(ForwardIt first, ForwardIt last, Search search, std::size_t capacity,
+                                                       unsigned shards = 16, bool tinylfu = false){
+    return CachedSearch<ForwardIt, T, Search>(first, last, search, capacity, shards, tinylfu);
+}
+
+#endif
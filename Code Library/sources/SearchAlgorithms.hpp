@@ -24,9 +24,35 @@
 #define SearchAlgorithms_hpp
 
 #include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include <math.h>
 
+//! Index types.
+
+/*
+ * Positions and sizes are template parameters (Index) of the search kernels, so arrays with more than
+ * 2^31 elements can be searched. The functions that take first and last run the kernel with 32-bit
+ * indexes when every size is at most SEARCH_INT32_LIMIT, which keeps the common case in 32-bit registers,
+ * and with std::ptrdiff_t otherwise. The limit leaves room for the probes that go past the end of the
+ * array (the doubling of exponential search, the Fibonacci numbers, the jump steps).
+ */
+#define SEARCH_INT32_LIMIT (INT32_MAX / 2)
+
+/*!
+ * \brief Calls fn(n) with n converted to std::int32_t if it is at most SEARCH_INT32_LIMIT, or as std::ptrdiff_t.
+ */
+template<class Function>
+auto index_dispatch(std::ptrdiff_t n, Function fn) -> decltype(fn(n)){
+    if(n <= SEARCH_INT32_LIMIT)
+        return fn((std::int32_t)n);
+    return fn(n);
+}
+
 //! One-dimensional search functions.
 
 /*!
@@ -45,16 +71,15 @@ bool linear_search(ForwardIt first, ForwardIt last, const T& value){
 }
 
 /*!
- * \brief Linear search function.
+ * \brief Jump search kernel over n elements with positions of type Index.
  * \param first iterator to start of array.
- * \param last iterator to end of array.
+ * \param n size of the array.
  * \param  value is the search key.
  */
-template<class ForwardIt, class T>
-bool jump_search(ForwardIt first, ForwardIt last, const T& value){
-    int i, n, step, j;
+template<class Index, class ForwardIt, class T>
+bool jump_search_n(ForwardIt first, Index n, const T& value){
+    Index i, step, j;
     i = 0;
-    n = last - first;
     step = std::sqrt(n);
     j = step;
     while(j < n){
@@ -77,21 +102,31 @@ bool jump_search(ForwardIt first, ForwardIt last, const T& value){
     return false;
 }
 
-
 /*!
- * \brief Interpolation search function.
+ * \brief Linear search function.
  * \param first iterator to start of array.
  * \param last iterator to end of array.
  * \param  value is the search key.
  */
 template<class ForwardIt, class T>
-bool interpolation_search(ForwardIt first, ForwardIt last, const T& value){
-    int i, n, j;
+bool jump_search(ForwardIt first, ForwardIt last, const T& value){
+    return index_dispatch(last - first, [&](auto n){ return jump_search_n(first, n, value); });
+}
+
+
+/*!
+ * \brief Interpolation search kernel over n elements with positions of type Index.
+ * \param first iterator to start of array.
+ * \param n size of the array.
+ * \param  value is the search key.
+ */
+template<class Index, class ForwardIt, class T>
+bool interpolation_search_n(ForwardIt first, Index n, const T& value){
+    Index i, j;
     i = 0;
-    n = last - first;
     j = n-1;
     while(i <= j && first[i] != first[j] && value >= first[i] && value <= first[j]){
-        int p = i + (((double)(j-i) / (first[j]-first[i]))*(value - first[i]));
+        Index p = i + (((double)(j-i) / (first[j]-first[i]))*(value - first[i]));
         if( value == first[p]){
             return true;
         }
@@ -100,41 +135,60 @@ bool interpolation_search(ForwardIt first, ForwardIt last, const T& value){
         else
             i = p+1;
     }
-    if(i < n-1 && value == first[i])
+    if(i < n && value == first[i])
     	return true;
     return false;
 }
 
 /*!
- * \brief Exponential search function.
+ * \brief Interpolation search function.
  * \param first iterator to start of array.
  * \param last iterator to end of array.
  * \param  value is the search key.
  */
 template<class ForwardIt, class T>
-bool exponential_search(ForwardIt first, ForwardIt last, const T& value){
-    int n;
-    n = last - first;
+bool interpolation_search(ForwardIt first, ForwardIt last, const T& value){
+    return index_dispatch(last - first, [&](auto n){ return interpolation_search_n(first, n, value); });
+}
+
+/*!
+ * \brief Exponential search kernel over n elements with positions of type Index.
+ * \param first iterator to start of array.
+ * \param n size of the array.
+ * \param  value is the search key.
+ */
+template<class Index, class ForwardIt, class T>
+bool exponential_search_n(ForwardIt first, Index n, const T& value){
     if(first[0] == value) 
         return true;
-    int i = 1;
+    Index i = 1;
     while(i < n && value > first[i]){
         i *= 2;
     }
     return std::binary_search( first+(i/2+1), first + ((i < n)? i+1 : n), value);
 }
 
-
 /*!
- * \brief Fiboncci search function.
+ * \brief Exponential search function.
  * \param first iterator to start of array.
  * \param last iterator to end of array.
  * \param  value is the search key.
  */
 template<class ForwardIt, class T>
-bool fibonaccian_search(ForwardIt first, ForwardIt last, const T& value){
-    int f, f1, f2, n, offset, p;
-    n = last - first;
+bool exponential_search(ForwardIt first, ForwardIt last, const T& value){
+    return index_dispatch(last - first, [&](auto n){ return exponential_search_n(first, n, value); });
+}
+
+
+/*!
+ * \brief Fibonaccian search kernel over n elements with positions of type Index.
+ * \param first iterator to start of array.
+ * \param n size of the array.
+ * \param  value is the search key.
+ */
+template<class Index, class ForwardIt, class T>
+bool fibonaccian_search_n(ForwardIt first, Index n, const T& value){
+    Index f, f1, f2, offset, p;
     f2 = 0;
     f1 = 1;
     f = f1 + f2;
@@ -160,12 +214,415 @@ bool fibonaccian_search(ForwardIt first, ForwardIt last, const T& value){
         }
     }
     
-    if(f > 0 && first[offset+1] == value){
+    if(f > 0 && offset+1 < n && first[offset+1] == value){
         return true;
     }
     return false;
 }
 
+/*!
+ * \brief Fiboncci search function.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ */
+template<class ForwardIt, class T>
+bool fibonaccian_search(ForwardIt first, ForwardIt last, const T& value){
+    return index_dispatch(last - first, [&](auto n){ return fibonaccian_search_n(first, n, value); });
+}
+
+
+/*!
+ * \brief Linear search function that returns the position of the first element not less than value.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ * \return position of the first element not less than value, or the size of the array if there is none.
+ */
+template<class ForwardIt, class T>
+std::ptrdiff_t linear_lower_bound(ForwardIt first, ForwardIt last, const T& value){
+    std::ptrdiff_t n = last - first;
+    for( std::ptrdiff_t i = 0; i < n; ++i)
+        if( !(first[i] < value))
+            return i;
+    return n;
+}
+
+/*!
+ * \brief Jump search kernel that returns the position of the first element not less than value.
+ * \param first iterator to start of array.
+ * \param n size of the array.
+ * \param  value is the search key.
+ */
+template<class Index, class ForwardIt, class T>
+Index jump_lower_bound_n(ForwardIt first, Index n, const T& value){
+    Index i, step, j;
+    i = 0;
+    step = std::sqrt(n);
+    if(step < 1)
+        step = 1;
+    j = step;
+    while(j < n && first[j] < value){
+        i = j+1;
+        j += step;
+    }
+    j = j<n? j : n;
+    while(i < j && first[i] < value)
+        ++i;
+    return i;
+}
+
+/*!
+ * \brief Jump search function that returns the position of the first element not less than value.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ */
+template<class ForwardIt, class T>
+std::ptrdiff_t jump_lower_bound(ForwardIt first, ForwardIt last, const T& value){
+    return index_dispatch(last - first, [&](auto n){ return jump_lower_bound_n(first, n, value); });
+}
+
+/*!
+ * \brief Interpolation search kernel that returns the position of the first element not less than value.
+ * \param first iterator to start of array.
+ * \param n size of the array.
+ * \param  value is the search key.
+ */
+template<class Index, class ForwardIt, class T>
+Index interpolation_lower_bound_n(ForwardIt first, Index n, const T& value){
+    Index lo = 0, hi = n;
+    while(lo < hi){
+        if( !(first[lo] < value))
+            return lo;
+        if( first[hi-1] < value)
+            return hi;
+        /* first[lo] < value <= first[hi-1] */
+        Index p = lo + (Index)((double)(value - first[lo]) / (first[hi-1] - first[lo]) * (hi-1-lo));
+        p = p < lo? lo : (p > hi-1? hi-1 : p);
+        if( first[p] < value)
+            lo = p+1;
+        else
+            hi = p;
+    }
+    return lo;
+}
+
+/*!
+ * \brief Interpolation search function that returns the position of the first element not less than value.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ */
+template<class ForwardIt, class T>
+std::ptrdiff_t interpolation_lower_bound(ForwardIt first, ForwardIt last, const T& value){
+    return index_dispatch(last - first, [&](auto n){ return interpolation_lower_bound_n(first, n, value); });
+}
+
+/*!
+ * \brief Exponential search kernel that returns the position of the first element not less than value.
+ * \param first iterator to start of array.
+ * \param n size of the array.
+ * \param  value is the search key.
+ */
+template<class Index, class ForwardIt, class T>
+Index exponential_lower_bound_n(ForwardIt first, Index n, const T& value){
+    if(n == 0 || !(first[0] < value))
+        return 0;
+    Index i = 1;
+    while(i < n && first[i] < value)
+        i *= 2;
+    return std::lower_bound(first+(i/2+1), first + ((i < n)? i+1 : n), value) - first;
+}
+
+/*!
+ * \brief Exponential search function that returns the position of the first element not less than value.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ */
+template<class ForwardIt, class T>
+std::ptrdiff_t exponential_lower_bound(ForwardIt first, ForwardIt last, const T& value){
+    return index_dispatch(last - first, [&](auto n){ return exponential_lower_bound_n(first, n, value); });
+}
+
+/*!
+ * \brief Fibonaccian search kernel that returns the position of the first element not less than value.
+ * \param first iterator to start of array.
+ * \param n size of the array.
+ * \param  value is the search key.
+ */
+template<class Index, class ForwardIt, class T>
+Index fibonaccian_lower_bound_n(ForwardIt first, Index n, const T& value){
+    Index f, f1, f2, offset, p;
+    f2 = 0;
+    f1 = 1;
+    f = f1 + f2;
+    while(f < n+1){
+        f2 = f1;
+        f1 = f;
+        f = f1 + f2;
+    }
+    /* The answer is in (offset, offset+f]. */
+    offset = -1;
+    while(f > 1){
+        p = (offset + f2) < n-1? offset+f2 : n-1;
+        if(first[p] < value){
+            f = f1;
+            f1 = f2;
+            f2 = f - f1;
+            offset = p;
+        }else{
+            f = f2;
+            f1 -= f2;
+            f2 = f - f1;
+        }
+    }
+    return offset+1;
+}
+
+/*!
+ * \brief Fibonaccian search function that returns the position of the first element not less than value.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ */
+template<class ForwardIt, class T>
+std::ptrdiff_t fibonaccian_lower_bound(ForwardIt first, ForwardIt last, const T& value){
+    return index_dispatch(last - first, [&](auto n){ return fibonaccian_lower_bound_n(first, n, value); });
+}
+
+/*!
+ * \brief Predecessor function.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ * \return position of the last element not greater than value, or -1 if there is none.
+ */
+template<class ForwardIt, class T>
+std::ptrdiff_t predecessor(ForwardIt first, ForwardIt last, const T& value){
+    return (std::upper_bound(first, last, value) - first) - 1;
+}
+
+/*!
+ * \brief Successor function.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ * \return position of the first element not less than value, or the size of the array if there is none.
+ */
+template<class ForwardIt, class T>
+std::ptrdiff_t successor(ForwardIt first, ForwardIt last, const T& value){
+    return std::lower_bound(first, last, value) - first;
+}
+
+//! One-dimensional search functions for fixed-size arrays.
+
+/*
+ * The probe schedules below (the jump step, the Fibonacci numbers and the doubling bounds)
+ * depend only on the array size, so they are computed at compile time and every probe loop
+ * is unrolled by template recursion. Intended for small lookup tables.
+ */
+
+/*!
+ * \brief Floor of the square root of n, evaluated at compile time.
+ */
+constexpr std::size_t fixed_sqrt(std::size_t n){
+    std::size_t r = 0;
+    while((r+1)*(r+1) <= n)
+        ++r;
+    return r;
+}
+
+/*!
+ * \brief k-th Fibonacci number, evaluated at compile time (F(-1) = 1, F(0) = 0, F(1) = 1).
+ */
+constexpr std::ptrdiff_t fixed_fibonacci(int k){
+    std::ptrdiff_t f2 = 1, f1 = 0;
+    for( int i = 0; i < k; ++i){
+        std::ptrdiff_t f = f1 + f2;
+        f2 = f1;
+        f1 = f;
+    }
+    return k < 0 ? 1 : f1;
+}
+
+/*!
+ * \brief Smallest index k such that F(k) >= n, starting from k = 2 as fibonaccian_search does.
+ */
+constexpr int fixed_fibonacci_index(std::size_t n){
+    int k = 2;
+    while(fixed_fibonacci(k) < (std::ptrdiff_t)n)
+        ++k;
+    return k;
+}
+
+/*!
+ * \brief Branchless lower bound over Len elements, unrolled at compile time.
+ * \param base pointer to start of array.
+ * \param  value is the search key.
+ */
+template<std::size_t Len, class T, class U>
+const T* fixed_lower_bound(const T* base, const U& value){
+    if constexpr (Len == 0){
+        return base;
+    }else if constexpr (Len == 1){
+        return base + (*base < value);
+    }else{
+        constexpr std::size_t half = Len/2;
+        base = (base[half-1] < value)? base+half : base;
+        return fixed_lower_bound<Len-half>(base, value);
+    }
+}
+
+/*!
+ * \brief Unrolled jumps of the fixed-size jump search. J is the current jump position and Step the jump size.
+ */
+template<std::size_t J, std::size_t Step, std::size_t N, class T, class U>
+bool fixed_jump_search(const T* first, const U& value){
+    if constexpr (J < N){
+        if( value == first[J])
+            return true;
+        if( value > first[J])
+            return fixed_jump_search<J+Step, Step, N>(first, value);
+        return linear_search(first + (J-Step), first + J + 1, value);
+    }else{
+        return linear_search(first + (J-Step), first + N, value);
+    }
+}
+
+/*!
+ * \brief Unrolled probes of the fixed-size Fibonacci search. K is the index of the current Fibonacci number.
+ */
+template<int K, std::size_t N, class T, class U>
+bool fixed_fibonaccian_search(const T* first, std::ptrdiff_t offset, const U& value){
+    if constexpr (fixed_fibonacci(K) <= 1){
+        return fixed_fibonacci(K) > 0 && offset+1 < (std::ptrdiff_t)N && first[offset+1] == value;
+    }else{
+        std::ptrdiff_t p = std::min<std::ptrdiff_t>(offset + fixed_fibonacci(K-2), N-1);
+        if( value > first[p])
+            return fixed_fibonaccian_search<K-1, N>(first, p, value);
+        if( value < first[p])
+            return fixed_fibonaccian_search<K-2, N>(first, offset, value);
+        return true;
+    }
+}
+
+/*!
+ * \brief Unrolled doubling of the fixed-size exponential search. I is the current bound.
+ */
+template<std::size_t I, std::size_t N, class T, class U>
+bool fixed_exponential_search(const T* first, const U& value){
+    if constexpr (I < N){
+        if( value > first[I])
+            return fixed_exponential_search<I*2, N>(first, value);
+    }
+    constexpr std::size_t lo = I/2+1;
+    constexpr std::size_t hi = I < N ? I+1 : N;
+    const T* p = fixed_lower_bound<hi-lo>(first+lo, value);
+    return p != first+hi && !(value < *p);
+}
+
+/*!
+ * \brief Binary search function for fixed-size arrays.
+ * \param a array.
+ * \param  value is the search key.
+ */
+template<class T, std::size_t N, class U>
+bool binary_search(const std::array<T, N>& a, const U& value){
+    const T* p = fixed_lower_bound<N>(a.data(), value);
+    return p != a.data()+N && !(value < *p);
+}
+
+/*!
+ * \brief Jump search function for fixed-size arrays.
+ * \param a array.
+ * \param  value is the search key.
+ */
+template<class T, std::size_t N, class U>
+bool jump_search(const std::array<T, N>& a, const U& value){
+    if constexpr (N == 0){
+        return false;
+    }else{
+        constexpr std::size_t step = fixed_sqrt(N);
+        return fixed_jump_search<step, step, N>(a.data(), value);
+    }
+}
+
+/*!
+ * \brief Exponential search function for fixed-size arrays.
+ * \param a array.
+ * \param  value is the search key.
+ */
+template<class T, std::size_t N, class U>
+bool exponential_search(const std::array<T, N>& a, const U& value){
+    if constexpr (N == 0){
+        return false;
+    }else{
+        if(a[0] == value)
+            return true;
+        return fixed_exponential_search<1, N>(a.data(), value);
+    }
+}
+
+/*!
+ * \brief Fibonacci search function for fixed-size arrays.
+ * \param a array.
+ * \param  value is the search key.
+ */
+template<class T, std::size_t N, class U>
+bool fibonaccian_search(const std::array<T, N>& a, const U& value){
+    if constexpr (N == 0){
+        return false;
+    }else{
+        return fixed_fibonaccian_search<fixed_fibonacci_index(N), N>(a.data(), -1, value);
+    }
+}
+
+/*!
+ * \brief Binary search function for built-in arrays.
+ * \param a array.
+ * \param  value is the search key.
+ */
+template<class T, std::size_t N, class U>
+bool binary_search(const T (&a)[N], const U& value){
+    const T* p = fixed_lower_bound<N>(a, value);
+    return p != a+N && !(value < *p);
+}
+
+/*!
+ * \brief Jump search function for built-in arrays.
+ * \param a array.
+ * \param  value is the search key.
+ */
+template<class T, std::size_t N, class U>
+bool jump_search(const T (&a)[N], const U& value){
+    constexpr std::size_t step = fixed_sqrt(N);
+    return fixed_jump_search<step, step, N>(a, value);
+}
+
+/*!
+ * \brief Exponential search function for built-in arrays.
+ * \param a array.
+ * \param  value is the search key.
+ */
+template<class T, std::size_t N, class U>
+bool exponential_search(const T (&a)[N], const U& value){
+    if(a[0] == value)
+        return true;
+    return fixed_exponential_search<1, N>(a, value);
+}
+
+/*!
+ * \brief Fibonacci search function for built-in arrays.
+ * \param a array.
+ * \param  value is the search key.
+ */
+template<class T, std::size_t N, class U>
+bool fibonaccian_search(const T (&a)[N], const U& value){
+    return fixed_fibonaccian_search<fixed_fibonacci_index(N), N>(a, -1, value);
+}
+
 
 //! Two-dimensional search functions.
 
@@ -179,9 +636,9 @@ bool fibonaccian_search(ForwardIt first, ForwardIt last, const T& value){
  * \param jn rightmost j position of the array.
  * \param  value is the search key.
  */
-template<class ForwardIt, class T>
-bool saddleback_search(ForwardIt first, int i1, int j1, int in, int jn, const T& value){
-    int  i, j;
+template<class ForwardIt, class Index, class T>
+bool saddleback_search(ForwardIt first, Index i1, Index j1, Index in, Index jn, const T& value){
+    Index  i, j;
     i = i1;
     j = jn;
     while( i <= in && j >= j1){
@@ -205,9 +662,11 @@ bool saddleback_search(ForwardIt first, int i1, int j1, int in, int jn, const T&
  */
 template<class ForwardIt, class T>
 bool saddleback_search(ForwardIt first, ForwardIt last,  const T& value){
-   int jn = first[0].size()-1;
-   int in = last - first - 1;
-   return saddleback_search(first, 0, 0, in, jn, value);
+   std::ptrdiff_t m = last - first, n = first[0].size();
+   return index_dispatch(std::max(m, n), [&](auto size){
+       typedef decltype(size) Index;
+       return saddleback_search(first, (Index)0, (Index)0, (Index)(m-1), (Index)(n-1), value);
+   });
 }
 
 /*!
@@ -217,21 +676,21 @@ bool saddleback_search(ForwardIt first, ForwardIt last,  const T& value){
  * \param jn rightmost j position of the array.
  * \param  value is the search key.
  */
-template<class ForwardIt, class T>
-bool binary_search(ForwardIt first, int i1, int j1, int in, int jn, const T& value){
-    int lower, high;
+template<class ForwardIt, class Index, class T>
+bool binary_search(ForwardIt first, Index i1, Index j1, Index in, Index jn, const T& value){
+    Index lower, high;
     if((in-i1+1) < 4){
-        for( int i = i1; i <= in ; i++){
+        for( Index i = i1; i <= in ; i++){
             if(std::binary_search(first[i].begin(), first[i].end(), value)){
                 return true;
             }
         }
     }else{
-        for( int i = j1; i <= jn; i++){
+        for( Index i = j1; i <= jn; i++){
             lower = i1;
             high = in;
             while( lower <= high){
-                int mid = (lower+high)>>1;
+                Index mid = (lower+high)>>1;
                 if( value == first[mid][i])
                     return true;
                 else if( value < first[mid][i])
@@ -250,26 +709,27 @@ bool binary_search(ForwardIt first, int i1, int j1, int in, int jn, const T& val
  * \param  j1 leftmost j position of the array.
  * \param jn rightmost j position of the array.
  * \param  value is the search key.
+ * \param leaf sub-arrays with fewer rows or columns than leaf are searched by binary search.
  */
-template<class ForwardIt, class T>
-bool shen_search(ForwardIt first, int i1,int j1, int in, int jn, const T& value){
-    if((in - i1+1) < 4 || (jn-j1+1) < 4){
+template<class ForwardIt, class Index, class T>
+bool shen_search(ForwardIt first, Index i1,Index j1, Index in, Index jn, const T& value, int leaf = 4){
+    if((in - i1+1) < leaf || (jn-j1+1) < leaf){
         return binary_search(first, i1,j1, in, jn, value);
     }
-    int i = (i1+in)>>1;
+    Index i = (i1+in)>>1;
     if(value == first[i][j1])
     	return true;
     else{
     	if( value < first[i][j1])
-        	return shen_search(first, i1, j1, i-1, jn, value);
+        	return shen_search(first, i1, j1, i-1, jn, value, leaf);
         else{
 	        if( value > first[i][jn])
-	            return shen_search(first, i+1, j1, in, jn, value);
+	            return shen_search(first, i+1, j1, in, jn, value, leaf);
 	        else{
-	            int j;
-	            j = lower_bound(first[i].begin() + j1, first[i].begin()+jn+1, value) - first[i].begin();
+	            Index j;
+	            j = std::lower_bound(first[i].begin() + j1, first[i].begin()+jn+1, value) - first[i].begin();
 	            if( first[i][j] != value)
-	                return shen_search(first, i+1, j1, in, j, value) || shen_search(first, i1, j+1,  i-1, jn, value);
+	                return shen_search(first, i+1, j1, in, j-1, value, leaf) || shen_search(first, i1, j,  i-1, jn, value, leaf);
 	            else
 	                return true;
 	        }
@@ -283,15 +743,237 @@ bool shen_search(ForwardIt first, int i1,int j1, int in, int jn, const T& value)
  * \param first iterator to start of array.
  * \param last iterator to end of array.
  * \param  value is the search key.
+ * \param leaf sub-arrays with fewer rows or columns than leaf are searched by binary search.
+ */
+template<class ForwardIt, class T>
+bool shen_search(ForwardIt first, ForwardIt last, const T& value, int leaf = 4){
+    std::ptrdiff_t m = last - first, n = first[0].size();
+    return index_dispatch(std::max(m, n), [&](auto size){
+        typedef decltype(size) Index;
+        return shen_search(first, (Index)0, (Index)0, (Index)(m-1), (Index)(n-1), value, leaf < 2? 2 : leaf);
+    });
+}
+
+
+/*!
+ * \brief Rank function: number of elements less than value, by a staircase walk in O(m+n).
+ * \param first iterator to start of array.
+ * \param  j1 leftmost j position of the array.
+ * \param jn rightmost j position of the array.
+ * \param  value is the search key.
+ */
+template<class ForwardIt, class Index, class T>
+std::int64_t matrix_rank(ForwardIt first, Index i1, Index j1, Index in, Index jn, const T& value){
+    std::int64_t rank = 0;
+    Index j = jn+1;
+    for( Index i = i1; i <= in && j > j1; ++i){
+        while(j > j1 && !(first[i][j-1] < value))
+            j--;
+        rank += j - j1;
+    }
+    return rank;
+}
+
+/*!
+ * \brief Rank function: number of elements less than value.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
  */
 template<class ForwardIt, class T>
-bool shen_search(ForwardIt first, ForwardIt last, const T& value){
-	int j = (int)first[0].size()-1;
-	int in = last - first - 1;
-    return shen_search(first, 0, 0, in, j, value);
+std::int64_t matrix_rank(ForwardIt first, ForwardIt last, const T& value){
+    std::ptrdiff_t m = last - first;
+    if(m == 0)
+        return 0;
+    std::ptrdiff_t n = first[0].size();
+    return index_dispatch(std::max(m, n), [&](auto size){
+        typedef decltype(size) Index;
+        return matrix_rank(first, (Index)0, (Index)0, (Index)(m-1), (Index)(n-1), value);
+    });
+}
+
+/*!
+ * \brief Value at which the weights of pairs sorted by value first exceed k (weighted selection, in place).
+ */
+template<class T>
+T weighted_select(std::vector<std::pair<T, std::int64_t> >& items, std::int64_t k){
+    std::size_t a = 0, b = items.size();
+    for( ; ; ){
+        std::size_t c = (a+b)>>1;
+        std::nth_element(items.begin()+a, items.begin()+c, items.begin()+b,
+                         [](const std::pair<T, std::int64_t>& x, const std::pair<T, std::int64_t>& y){ return x.first < y.first; });
+        std::int64_t w = 0;
+        for( std::size_t t = a; t < c; ++t)
+            w += items[t].second;
+        if(k < w)
+            b = c;
+        else if(k < w + items[c].second)
+            return items[c].first;
+        else{
+            k -= w + items[c].second;
+            a = c+1;
+        }
+    }
+}
+
+/*!
+ * \brief Submatrix of candidates in matrix_select: rows [i, i+h) and columns [j, j+w), clipped to the matrix.
+ */
+template<class T>
+struct SelectCell{
+    std::ptrdiff_t i, j;
+    T low, high;
+    std::int64_t weight;
+};
+
+/*!
+ * \brief Selection function: k-th smallest element (from 0) of a two-dimensional sorted array.
+ *
+ * Frederickson-Johnson selection on an m x n matrix with m <= n (the transpose is used otherwise).
+ * The candidates are kept as a set of h x w submatrices, whose smallest and largest elements are
+ * their top left and bottom right corners; h and w start at the powers of two that cover the matrix,
+ * so the grid of submatrices has about as many rows as columns. Every round splits each submatrix in
+ * four (only the columns in two once h is 1) and then prunes with two weighted selections over the
+ * corners: U is the smallest corner max with at least k+1 candidates at or below it, L the largest
+ * corner min with enough candidates at or above it, and every submatrix that lies entirely above U
+ * or below L is discarded. Only submatrices that hold L or U on their staircase survive, O(m/h) of
+ * them while h > 1 and O(m) afterwards, so the total cost is O(m log(2n/m)) time and O(m) memory;
+ * no element is ranked by a staircase walk over the matrix.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param k rank of the element, 0 <= k < m*n.
+ * \return the element, or a value-initialized T if the matrix is empty or k is out of range.
+ */
+template<class ForwardIt>
+typename std::decay<decltype(std::declval<ForwardIt>()[0][0])>::type matrix_select(ForwardIt first, ForwardIt last, std::int64_t k){
+    typedef typename std::decay<decltype(first[0][0])>::type T;
+    std::ptrdiff_t rows = last - first;
+    if(rows <= 0 || first[0].size() == 0 || k < 0 || k >= (std::int64_t)rows * (std::ptrdiff_t)first[0].size())
+        return T();
+    std::ptrdiff_t cols = first[0].size();
+    bool transposed = cols < rows;
+    std::ptrdiff_t m = transposed? cols : rows, n = transposed? rows : cols;
+    auto at = [&](std::ptrdiff_t i, std::ptrdiff_t j) -> T{ return transposed? first[j][i] : first[i][j]; };
+
+    std::ptrdiff_t h = 1, w = 1;
+    while(h < m)
+        h <<= 1;
+    while(w < n)
+        w <<= 1;
+    std::vector<SelectCell<T> > cells, next;
+    std::vector<std::pair<T, std::int64_t> > corners;
+    cells.push_back(SelectCell<T>{0, 0, at(0, 0), at(m-1, n-1), (std::int64_t)m*n});
+    while(h > 1 || w > 1){
+        /* Split: both sides while h > 1, then only the columns. */
+        std::ptrdiff_t h2 = h > 1? h/2 : 1, w2 = w/2;
+        next.clear();
+        for( std::size_t c = 0; c < cells.size(); ++c){
+            for( std::ptrdiff_t di = 0; di < h; di += h2){
+                std::ptrdiff_t i = cells[c].i + di;
+                if(i >= m)
+                    break;
+                for( std::ptrdiff_t dj = 0; dj < w; dj += w2){
+                    std::ptrdiff_t j = cells[c].j + dj;
+                    if(j >= n)
+                        break;
+                    std::ptrdiff_t ie = std::min(i + h2, m), je = std::min(j + w2, n);
+                    next.push_back(SelectCell<T>{i, j, at(i, j), at(ie-1, je-1), (std::int64_t)(ie-i)*(je-j)});
+                }
+            }
+        }
+        cells.swap(next);
+        h = h2;
+        w = w2;
+
+        /* The answer is not greater than U and not less than L. */
+        corners.clear();
+        for( std::size_t c = 0; c < cells.size(); ++c)
+            corners.push_back(std::make_pair(cells[c].high, cells[c].weight));
+        T upper = weighted_select(corners, k);
+        corners.clear();
+        for( std::size_t c = 0; c < cells.size(); ++c)
+            corners.push_back(std::make_pair(cells[c].low, cells[c].weight));
+        T lower = weighted_select(corners, k);
+        if(!(lower < upper))
+            return lower;
+        next.clear();
+        for( std::size_t c = 0; c < cells.size(); ++c){
+            if(cells[c].high < lower)
+                k -= cells[c].weight;
+            else if(!(upper < cells[c].low))
+                next.push_back(cells[c]);
+        }
+        cells.swap(next);
+    }
+    corners.clear();
+    for( std::size_t c = 0; c < cells.size(); ++c)
+        corners.push_back(std::make_pair(cells[c].low, (std::int64_t)1));
+    return weighted_select(corners, k);
 }
 
 
+/*!
+ * \brief Predecessor function: the largest element not greater than value, found on the staircase frontier in O(m+n).
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ * \param pi row of the predecessor.
+ * \param pj column of the predecessor.
+ * \return false if every element is greater than value.
+ */
+template<class ForwardIt, class T, class Index>
+bool predecessor_2D(ForwardIt first, ForwardIt last, const T& value, Index& pi, Index& pj){
+    static_assert(std::is_signed<Index>::value, "the staircase walks step below column 0");
+    Index m = last - first;
+    if(m == 0)
+        return false;
+    bool found = false;
+    Index j = (Index)first[0].size()-1;
+    for( Index i = 0; i < m && j >= 0; ++i){
+        while(j >= 0 && value < first[i][j])
+            j--;
+        if(j >= 0 && (!found || first[pi][pj] < first[i][j])){
+            found = true;
+            pi = i;
+            pj = j;
+            if(first[i][j] == value)
+                return true;
+        }
+    }
+    return found;
+}
+
+/*!
+ * \brief Successor function: the smallest element not less than value, found on the staircase frontier in O(m+n).
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ * \param si row of the successor.
+ * \param sj column of the successor.
+ * \return false if every element is less than value.
+ */
+template<class ForwardIt, class T, class Index>
+bool successor_2D(ForwardIt first, ForwardIt last, const T& value, Index& si, Index& sj){
+    static_assert(std::is_signed<Index>::value, "the staircase walks step below column 0");
+    Index m = last - first;
+    if(m == 0)
+        return false;
+    bool found = false;
+    Index n = first[0].size(), j = n;
+    for( Index i = 0; i < m; ++i){
+        while(j > 0 && !(first[i][j-1] < value))
+            j--;
+        if(j < n && (!found || first[i][j] < first[si][sj])){
+            found = true;
+            si = i;
+            sj = j;
+            if(first[i][j] == value)
+                return true;
+        }
+    }
+    return found;
+}
+
 /* Three-dimensional search functions */
 
 /*
@@ -326,9 +1008,9 @@ bool shen_search(ForwardIt first, ForwardIt last, const T& value){
  * \param k array k postition.
  * \param  value is the search key.
  */
-template<class ForwardIt, class T>
-bool saddleback_ij(ForwardIt first, int i1, int in, int j1, int jn, int k, const T& value){
-    int x, y;
+template<class ForwardIt, class Index, class T>
+bool saddleback_ij(ForwardIt first, Index i1, Index in, Index j1, Index jn, Index k, const T& value){
+    Index x, y;
     x = i1;
     y = jn;
     while(x <= in && y >= j1){
@@ -353,9 +1035,9 @@ bool saddleback_ij(ForwardIt first, int i1, int in, int j1, int jn, int k, const
  * \param kn rightmost k position of the array.
  * \param  value is the search key.
  */
-template<class ForwardIt, class T>
-bool saddleback_ik(ForwardIt first, int i1, int in, int j, int k1, int kn, const T& value){
-    int x, z;
+template<class ForwardIt, class Index, class T>
+bool saddleback_ik(ForwardIt first, Index i1, Index in, Index j, Index k1, Index kn, const T& value){
+    Index x, z;
     x = in;
     z = k1;
     while( x >= i1 && z <= kn){
@@ -379,9 +1061,9 @@ bool saddleback_ik(ForwardIt first, int i1, int in, int j, int k1, int kn, const
  * \param k2 rightmost k position of the array.
  * \param  value is the search key.
  */
-template<class ForwardIt, class T>
-bool saddleback_jk( ForwardIt first,  int i, int j1, int jn, int k1, int k2, const T& value){
-    int y, z;
+template<class ForwardIt, class Index, class T>
+bool saddleback_jk( ForwardIt first,  Index i, Index j1, Index jn, Index k1, Index k2, const T& value){
+    Index y, z;
     y = jn;
     z = k1;
     while(y >= j1 && z <= k2){
@@ -405,13 +1087,13 @@ bool saddleback_jk( ForwardIt first,  int i, int j1, int jn, int k1, int k2, con
  * \param k array k position.
  * \param  value is the search key.
  */
-template<class ForwardIt, class T>
-int binary_search_i(ForwardIt first, int i1, int in, int j, int k, const T& value){
-    int lo, hi;
+template<class ForwardIt, class Index, class T>
+Index binary_search_i(ForwardIt first, Index i1, Index in, Index j, Index k, const T& value){
+    Index lo, hi;
     lo = i1;
     hi = in;
     while(lo <= hi){
-        int mid = (lo+hi)>>1;
+        Index mid = (lo+hi)>>1;
         if( first[mid][j][k] < value)
             lo = mid+1;
         else if( first[mid][j][k] > value)
@@ -433,13 +1115,13 @@ int binary_search_i(ForwardIt first, int i1, int in, int j, int k, const T& valu
  * \param k array k position.
  * \param  value is the search key.
  */
-template<class ForwardIt, class T>
-int binary_search_j(ForwardIt first, int i, int j1, int jn, int k, const T& value){
-    int lo, hi; 
+template<class ForwardIt, class Index, class T>
+Index binary_search_j(ForwardIt first, Index i, Index j1, Index jn, Index k, const T& value){
+    Index lo, hi; 
     lo = j1;
     hi = jn;
     while(lo <= hi){
-        int mid = (lo+hi)>>1;
+        Index mid = (lo+hi)>>1;
         if( first[i][mid][k] < value)
             lo = mid+1;
         else if( first[i][mid][k] > value)
@@ -461,13 +1143,13 @@ int binary_search_j(ForwardIt first, int i, int j1, int jn, int k, const T& valu
  * \param  value is the search key.
  */
 
-template<class ForwardIt, class T>
-int binary_search_k(ForwardIt first, int i, int j, int k1, int kn, const T& value){
-    int lo, hi;
+template<class ForwardIt, class Index, class T>
+Index binary_search_k(ForwardIt first, Index i, Index j, Index k1, Index kn, const T& value){
+    Index lo, hi;
     lo = k1;
     hi = kn;
     while(lo <= hi){
-        int mid = (lo+hi)>>1;
+        Index mid = (lo+hi)>>1;
         if( first[i][j][mid] < value)
             lo = mid+1;
         else if( first[i][j][mid] > value)
@@ -490,8 +1172,8 @@ int binary_search_k(ForwardIt first, int i, int j, int k1, int kn, const T& valu
  * \param  value is the search key.
  */
 
-template<class ForwardIt, class T>
-bool linialsaks_search(ForwardIt first, int i1, int j1, int k1, int in, int jn, int kn, const T& value){
+template<class ForwardIt, class Index, class T>
+bool linialsaks_search(ForwardIt first, Index i1, Index j1, Index k1, Index in, Index jn, Index kn, const T& value){
     if(i1 > in || j1 > jn || k1 > kn)
         return false;
     if(i1 == in ||j1 == jn || k1 == kn){
@@ -513,7 +1195,7 @@ bool linialsaks_search(ForwardIt first, int i1, int j1, int k1, int in, int jn,
     	}
     }
 
-    int u1, u2, w1, w2, v1, v2;
+    Index u1, u2, w1, w2, v1, v2;
 
     /* Binary search in subarray u1. Variable u1 is the position returned in binary search. */
     u1 = binary_search_k(first, i1, jn, k1, kn, value);
@@ -580,11 +1262,11 @@ bool linialsaks_search(ForwardIt first, int i1, int j1, int k1, int in, int jn,
  */
 template<class ForwardIt, class T>
 bool linialsaks_search(ForwardIt first, ForwardIt last, const T& value){
-    int in, jn, kn;
-    in = (last - first) -1;
-    jn = first[0].size() - 1;
-    kn = first[0][0].size() - 1;
-    return linialsaks_search(first, 0, 0, 0, in, jn, kn, value);
+    std::ptrdiff_t m = last - first, n = first[0].size(), p = first[0][0].size();
+    return index_dispatch(std::max(m, std::max(n, p)), [&](auto size){
+        typedef decltype(size) Index;
+        return linialsaks_search(first, (Index)0, (Index)0, (Index)0, (Index)(m-1), (Index)(n-1), (Index)(p-1), value);
+    });
 }
 
 
@@ -603,6 +1285,14 @@ bool linialsaks_search(ForwardIt first, ForwardIt last, const T& value){
  
  */
 
+/*!
+ * \brief Prune predicate of MAHL_e that keeps every box.
+ */
+struct NoPrune{
+    template<class T, class Index>
+    bool operator()(const T&, Index, Index, Index, Index, Index, Index) const{ return true; }
+};
+
 /*!
  * \brief MAHL_e function.
  * \param first iterator to start of array.
@@ -613,31 +1303,36 @@ bool linialsaks_search(ForwardIt first, ForwardIt last, const T& value){
  * \param k1 leftmost k position of the array.
  * \param kn rightmost k position of the array.
  * \param  value is the search key.
+ * \param leaf boxes with a dimension of at most leaf (at least 2) are searched by saddleback.
+ * \param prune prune(value, i1, j1, k1, im, jn, kp) returns false for a box that cannot hold value, e.g. by
+ *  looking it up in a zone map; by default every box is searched.
  */
-template<class ForwardIt, class T>
-bool MAHL_e(ForwardIt first, int i1, int j1, int k1, int im, int jn, int kp, const T& value){
+template<class ForwardIt, class Index, class T, class Prune = NoPrune>
+bool MAHL_e(ForwardIt first, Index i1, Index j1, Index k1, Index im, Index jn, Index kp, const T& value, int leaf = 3, Prune prune = Prune()){
     if(i1 > im || j1 > jn || k1 > kp)
         return false;
-    int diff_i = im - i1 + 1;
-    int diff_j = jn - j1 + 1;
-    int diff_k = kp - k1 + 1;
+    if(!prune(value, i1, j1, k1, im, jn, kp))
+        return false;
+    Index diff_i = im - i1 + 1;
+    Index diff_j = jn - j1 + 1;
+    Index diff_k = kp - k1 + 1;
     /*If dimension i is less than 3 and smaller than dimensions j and k, apply the saddleback algorithm to it. */
-    if(diff_i <= 3 && diff_i <= diff_j && diff_i <= diff_k){
-        for( int i = i1; i <= im; ++i)
+    if(diff_i <= leaf && diff_i <= diff_j && diff_i <= diff_k){
+        for( Index i = i1; i <= im; ++i)
             if(saddleback_jk(first, i, j1, jn, k1, kp, value))
                 return true;
             return false;
     }
     /*If dimension j is less than 3 and smaller than dimensions i and k, apply the saddleback algorithm to it.*/
-    if(diff_j <= 3 && diff_j <= diff_i && diff_j <= diff_k){
-        for( int j = j1; j <= jn; ++j)
+    if(diff_j <= leaf && diff_j <= diff_i && diff_j <= diff_k){
+        for( Index j = j1; j <= jn; ++j)
             if(saddleback_ik(first, i1, im, j, k1, kp, value))
                 return true;
             return false;
     }
     /*If dimension k is less than 3 and smaller than dimensions i and j, apply the saddleback algorithm to it.*/
-    if(diff_k <= 3 && diff_k <= diff_i && diff_k <= diff_j){
-        for( int k = k1; k <= kp; ++k)
+    if(diff_k <= leaf && diff_k <= diff_i && diff_k <= diff_j){
+        for( Index k = k1; k <= kp; ++k)
             if(saddleback_ij(first, i1, im, j1, jn, k, value))
                 return true;
             return false;
@@ -645,40 +1340,40 @@ bool MAHL_e(ForwardIt first, int i1, int j1, int k1, int im, int jn, int kp, con
     
     /*If dimension i is larger, apply the algorithm to it.*/
     if(diff_i >= diff_j && diff_i >= diff_k){
-        int mid_j = (j1 + jn) >> 1; /* floor of N/2 */
-        int mid_k = (k1 + kp) >> 1; /*  floor of P/2 */
+        Index mid_j = (j1 + jn) >> 1; /* floor of N/2 */
+        Index mid_k = (k1 + kp) >> 1; /*  floor of P/2 */
         
-        int index_i = binary_search_i(first, i1, im, mid_j, mid_k, value);
+        Index index_i = binary_search_i(first, i1, im, mid_j, mid_k, value);
         if( index_i >= 0 && first[index_i][mid_j][mid_k] == value)
             return true;
         
-        return MAHL_e(first, index_i+1, j1, k1, im, mid_j, kp, value) ||
-        MAHL_e(first, i1, j1, mid_k, index_i, jn, kp, value) ||
-        MAHL_e(first, i1, mid_j+1, k1, im, jn, mid_k-1, value);
+        return MAHL_e(first, index_i+1, j1, k1, im, mid_j, kp, value, leaf, prune) ||
+        MAHL_e(first, i1, j1, mid_k, index_i, jn, kp, value, leaf, prune) ||
+        MAHL_e(first, i1, mid_j+1, k1, im, jn, mid_k-1, value, leaf, prune);
     }
     /*If dimension j is larger, apply the algorithm to it.*/
     else if(diff_j >= diff_i && diff_j >= diff_k){
-        int mid_i = (i1 + im) >> 1; /* floor of M/2 */
-        int mid_k = (k1 + kp) >> 1; /*  floor of P/2 */
+        Index mid_i = (i1 + im) >> 1; /* floor of M/2 */
+        Index mid_k = (k1 + kp) >> 1; /*  floor of P/2 */
         
-        int index_j = binary_search_j(first, mid_i, j1, jn, mid_k, value);
+        Index index_j = binary_search_j(first, mid_i, j1, jn, mid_k, value);
         if(index_j >= 0 && first[mid_i][index_j][mid_k] == value)
             return true;
-        return MAHL_e(first, mid_i, j1, k1, im, index_j, kp, value) ||
-        MAHL_e(first, i1, j1, mid_k, mid_i-1, jn, kp, value) || 
-        MAHL_e(first, i1, index_j+1, k1, im, jn, mid_k-1, value);
+        return MAHL_e(first, mid_i, j1, k1, im, index_j, kp, value, leaf, prune) ||
+        MAHL_e(first, i1, j1, mid_k, mid_i-1, jn, kp, value, leaf, prune) || 
+        MAHL_e(first, i1, index_j+1, k1, im, jn, mid_k-1, value, leaf, prune);
     }
     /*If dimension k is larger, apply the algorithm to it.*/
     else{
-        int mid_i = (i1 + im) >> 1; /* floor of M/2 */
-        int mid_j = (j1 + jn) >> 1; /* foor of N/2 */
+        Index mid_i = (i1 + im) >> 1; /* floor of M/2 */
+        Index mid_j = (j1 + jn) >> 1; /* foor of N/2 */
         
-        int index_k = binary_search_k(first, mid_i, mid_j, k1, kp, value);
+        Index index_k = binary_search_k(first, mid_i, mid_j, k1, kp, value);
         if(index_k >= 0 && first[mid_i][mid_j][index_k] == value)
             return true;
-        return MAHL_e(first, mid_i, j1, k1, im, mid_j, kp, value) ||
-        MAHL_e(first, i1, j1, index_k+1, mid_i-1, jn, kp, value) ||
-        MAHL_e(first, i1, mid_j+1, k1, im, jn, index_k, value);
+        return MAHL_e(first, mid_i, j1, k1, im, mid_j, kp, value, leaf, prune) ||
+        MAHL_e(first, i1, j1, index_k+1, mid_i-1, jn, kp, value, leaf, prune) ||
+        MAHL_e(first, i1, mid_j+1, k1, im, jn, index_k, value, leaf, prune);
     }
 }
 
@@ -693,14 +1388,103 @@ bool MAHL_e(ForwardIt first, int i1, int j1, int k1, int im, int jn, int kp, con
  * \param k1 leftmost k position of the array.
  * \param kn rightmost k position of the array.
  * \param  value is the search key.
+ * \param leaf boxes with a dimension of at most leaf (at least 2) are searched by saddleback.
  */
 template<class ForwardIt, class T>
-bool MAHL_e(ForwardIt first, ForwardIt last, const T& value){
-    int im, jn, kp;
-    im = (last - first) - 1;
-    jn = first[0].size() - 1;
-    kp = first[0][0].size() - 1;
-    return MAHL_e(first, 0, 0, 0, im, jn, kp, value);
+bool MAHL_e(ForwardIt first, ForwardIt last, const T& value, int leaf = 3){
+    std::ptrdiff_t m = last - first, n = first[0].size(), p = first[0][0].size();
+    return index_dispatch(std::max(m, std::max(n, p)), [&](auto size){
+        typedef decltype(size) Index;
+        return MAHL_e(first, (Index)0, (Index)0, (Index)0, (Index)(m-1), (Index)(n-1), (Index)(p-1), value, leaf < 2? 2 : leaf);
+    });
+}
+
+/*!
+ * \brief Predecessor function: the largest element not greater than value.
+ *
+ * Every layer i is walked along its staircase frontier, starting from the position that binary_search_k
+ * returns for the line (i, 0); layers that start above value end the walk. O(m(n+p)) in the worst case.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ * \param pi i position of the predecessor.
+ * \param pj j position of the predecessor.
+ * \param pk k position of the predecessor.
+ * \return false if every element is greater than value.
+ */
+template<class ForwardIt, class T, class Index>
+bool predecessor_3D(ForwardIt first, ForwardIt last, const T& value, Index& pi, Index& pj, Index& pk){
+    static_assert(std::is_signed<Index>::value, "the staircase walks step below column 0");
+    Index m = last - first;
+    if(m == 0)
+        return false;
+    Index n = first[0].size(), p = first[0][0].size();
+    bool found = false;
+    for( Index i = 0; i < m; ++i){
+        if(value < first[i][0][0])
+            break;
+        Index k = binary_search_k(first, i, (Index)0, (Index)0, (Index)(p-1), value);
+        for( Index j = 0; j < n && k >= 0; ++j){
+            while(k >= 0 && value < first[i][j][k])
+                k--;
+            if(k >= 0 && (!found || first[pi][pj][pk] < first[i][j][k])){
+                found = true;
+                pi = i;
+                pj = j;
+                pk = k;
+                if(first[i][j][k] == value)
+                    return true;
+            }
+        }
+    }
+    return found;
+}
+
+/*!
+ * \brief Successor function: the smallest element not less than value.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ * \param si i position of the successor.
+ * \param sj j position of the successor.
+ * \param sk k position of the successor.
+ * \return false if every element is less than value.
+ */
+template<class ForwardIt, class T, class Index>
+bool successor_3D(ForwardIt first, ForwardIt last, const T& value, Index& si, Index& sj, Index& sk){
+    static_assert(std::is_signed<Index>::value, "the staircase walks step below column 0");
+    Index m = last - first;
+    if(m == 0)
+        return false;
+    Index n = first[0].size(), p = first[0][0].size();
+    bool found = false;
+    for( Index i = 0; i < m; ++i){
+        if(first[i][n-1][p-1] < value)
+            continue;
+        if(!(first[i][0][0] < value)){
+            /* The layers below start even higher. */
+            if(!found || first[i][0][0] < first[si][sj][sk]){
+                found = true;
+                si = i;
+                sj = sk = 0;
+            }
+            break;
+        }
+        Index k = binary_search_k(first, i, (Index)0, (Index)0, (Index)(p-1), value) + 1;
+        for( Index j = 0; j < n; ++j){
+            while(k > 0 && !(first[i][j][k-1] < value))
+                k--;
+            if(k < p && (!found || first[i][j][k] < first[si][sj][sk])){
+                found = true;
+                si = i;
+                sj = j;
+                sk = k;
+                if(first[i][j][k] == value)
+                    return true;
+            }
+        }
+    }
+    return found;
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,566 @@
+/** \file SearchPlanner.hpp
+ * Choice of the one-dimensional search algorithm from a sample and a short calibration on the array itself.
+ */
+
+/*
+ *  SearchPlanner.hpp
+ *
+ *  Instituto de Informatica - UFG
+ *
+ */
+
+/*
+ * plan_search samples the array once and measures its size and how far it is from a straight line (the
+ * mean distance of the sample to the chord from the first to the last element, relative to the range).
+ * Algorithms that cannot win at that size are dropped: linear search above SEARCH_PLAN_LINEAR_MAX
+ * elements, jump search above SEARCH_PLAN_JUMP_MAX, interpolation for non-arithmetic types and above a
+ * linearity error of SEARCH_PLAN_NONLINEAR, where its probes degrade towards O(n). The others run the same
+ * set of probe keys, half of them taken from the array and half drawn between its first and last elements,
+ * and the fastest one is bound to the returned plan. A candidate whose round takes more than
+ * SEARCH_PLAN_BUDGET times the best round so far is abandoned, so an outlier the sample missed costs at
+ * most a few rounds of the best search.
+ *
+ * ShapeDispatcher does the same for the two- and three-dimensional searches, whose cost depends on the
+ * shape rather than on the values. calibrate tunes the leaf sizes of shen_search and MAHL_e and fits
+ * one constant per algorithm to a cost model in the dimensions (e.g. m + n for saddleback) from timings
+ * on a few square and skewed instances; any shape is then dispatched to the algorithm with the lowest
+ * predicted cost. The calibration can be saved to a text file and loaded later instead of measured again.
+ */
+
+#ifndef SearchPlanner_hpp
+#define SearchPlanner_hpp
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "GeneratorInstance.hpp"
+#include "SearchAlgorithms.hpp"
+
+#define SEARCH_PLAN_SAMPLE 1024
+#define SEARCH_PLAN_LINEAR_MAX 2048
+#define SEARCH_PLAN_JUMP_MAX (1 << 22)
+#define SEARCH_PLAN_NONLINEAR 0.1 /* Linearity error above which interpolation is not calibrated. */
+#define SEARCH_PLAN_BUDGET 4 /* Rounds slower than this many best rounds are abandoned. */
+#define SEARCH_CALIBRATION_VERSION 1
+#define SEARCH_CALIBRATION_QUERIES 256
+
+/*! One-dimensional search algorithms. */
+enum SearchAlgorithm1D{
+    SEARCH_LINEAR = 0,
+    SEARCH_JUMP,
+    SEARCH_BINARY,
+    SEARCH_INTERPOLATION,
+    SEARCH_EXPONENTIAL,
+    SEARCH_FIBONACCIAN,
+    SEARCH_ALGORITHMS_1D
+};
+
+inline const char* SearchAlgorithmName(SearchAlgorithm1D a){
+    static const char* names[SEARCH_ALGORITHMS_1D] = {"linear", "jump", "binary", "interpolation", "exponential", "fibonaccian"};
+    return a >= 0 && a < SEARCH_ALGORITHMS_1D? names[a] : "unknown";
+}
+
+/*!
+ * \brief Runs the one-dimensional search a on [first, last).
+ */
+template<class ForwardIt, class T>
+bool search_1D(SearchAlgorithm1D a, ForwardIt first, ForwardIt last, const T& value){
+    switch(a){
+    case SEARCH_LINEAR:
+        return linear_search(first, last, value);
+    case SEARCH_JUMP:
+        return jump_search(first, last, value);
+    case SEARCH_INTERPOLATION:
+        return interpolation_search(first, last, value);
+    case SEARCH_EXPONENTIAL:
+        return exponential_search(first, last, value);
+    case SEARCH_FIBONACCIAN:
+        return fibonaccian_search(first, last, value);
+    default:
+        return std::binary_search(first, last, value);
+    }
+}
+
+/*!
+ * \brief Search algorithm chosen for one array, bound to it.
+ */
+template<class ForwardIt, class T>
+class SearchPlan{
+public:
+    SearchPlan(ForwardIt first, ForwardIt last) : first(first), last(last), chosen(SEARCH_BINARY), error(0){
+        for( int a = 0; a < SEARCH_ALGORITHMS_1D; ++a){
+            cost[a] = -1;
+            skipped[a] = "size";
+        }
+    }
+
+    bool operator()(const T& value) const{
+        return search_1D(chosen, first, last, value);
+    }
+
+    SearchAlgorithm1D algorithm() const{ return chosen; }
+
+    /*!
+     * \brief Mean distance of the sample to the line through the first and last elements, relative to their difference.
+     */
+    double linearity_error() const{ return error; }
+
+    /*!
+     * \brief Measured nanoseconds per query of algorithm a, or a negative value if it was not calibrated.
+     */
+    double nanoseconds(SearchAlgorithm1D a) const{ return cost[a]; }
+
+    /*!
+     * \brief Human-readable reason for the choice.
+     */
+    std::string explain() const{
+        char buf[128];
+        std::snprintf(buf, sizeof(buf), "n = %lld, linearity error = %.4g;", (long long)(last - first), error);
+        std::string s = buf;
+        for( int a = 0; a < SEARCH_ALGORITHMS_1D; ++a){
+            if(cost[a] < 0)
+                std::snprintf(buf, sizeof(buf), " %s: skipped (%s);", SearchAlgorithmName((SearchAlgorithm1D)a), skipped[a]);
+            else
+                std::snprintf(buf, sizeof(buf), " %s: %.1f ns;", SearchAlgorithmName((SearchAlgorithm1D)a), cost[a]);
+            s += buf;
+        }
+        s += " chosen: ";
+        s += SearchAlgorithmName(chosen);
+        return s;
+    }
+
+    ForwardIt first, last;
+    SearchAlgorithm1D chosen;
+    double error;
+    double cost[SEARCH_ALGORITHMS_1D];
+    const char* skipped[SEARCH_ALGORITHMS_1D]; /* Why an algorithm was not calibrated. */
+};
+
+/*!
+ * \brief Linearity error of a sorted array, from SEARCH_PLAN_SAMPLE evenly spaced elements.
+ */
+template<class ForwardIt>
+double linearity_error(ForwardIt first, ForwardIt last){
+    std::int64_t n = last - first;
+    if(n < 3)
+        return 0;
+    double a = first[0], b = first[n-1];
+    if(b == a)
+        return 0;
+    std::int64_t s = std::min<std::int64_t>(n, SEARCH_PLAN_SAMPLE);
+    double e = 0;
+    for( std::int64_t t = 0; t < s; ++t){
+        std::int64_t i = t * (n-1) / (s-1);
+        double line = a + (b - a) * i / (n-1);
+        e += std::fabs(first[i] - line);
+    }
+    return e / s / std::fabs(b - a);
+}
+
+/*!
+ * \brief Samples and calibrates the searches on an array and returns the fastest one bound to it.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param probes number of probe keys of the calibration.
+ * \param seed seed of the probe keys.
+ */
+template<class T, class ForwardIt>
+SearchPlan<ForwardIt, T> plan_search(ForwardIt first, ForwardIt last, int probes = 512, std::uint64_t seed = 1){
+    SearchPlan<ForwardIt, T> plan(first, last);
+    std::int64_t n = last - first;
+    if(n < 2)
+        return plan;
+    bool arithmetic = std::is_arithmetic<T>::value;
+    if(arithmetic)
+        plan.error = linearity_error(first, last);
+
+    /* Probe keys: hits and keys spread over the range. */
+    std::mt19937_64 rng(seed);
+    std::vector<T> keys(probes);
+    for( int q = 0; q < probes; ++q){
+        if(q % 2 == 0 || !arithmetic)
+            keys[q] = first[rng() % n];
+        else{
+            double u = std::uniform_real_distribution<double>(0, 1)(rng);
+            keys[q] = (T)(first[0] + (first[n-1] - first[0]) * u);
+        }
+    }
+
+    bool run[SEARCH_ALGORITHMS_1D];
+    for( int a = 0; a < SEARCH_ALGORITHMS_1D; ++a)
+        run[a] = true;
+    run[SEARCH_LINEAR] = n <= SEARCH_PLAN_LINEAR_MAX;
+    run[SEARCH_JUMP] = n <= SEARCH_PLAN_JUMP_MAX;
+    run[SEARCH_INTERPOLATION] = arithmetic && plan.error <= SEARCH_PLAN_NONLINEAR;
+    plan.skipped[SEARCH_INTERPOLATION] = arithmetic? "nonlinear" : "not arithmetic";
+
+    double best = -1;
+    volatile int sink = 0;
+    for( int a = 0; a < SEARCH_ALGORITHMS_1D; ++a){
+        if(!run[a])
+            continue;
+        /* Best of three rounds, after a warm-up round. */
+        double t = -1, limit = best < 0? -1 : SEARCH_PLAN_BUDGET * best * probes;
+        for( int r = 0; r < 4 && t != -2; ++r){
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            int found = 0;
+            for( int q = 0; q < probes; ++q){
+                found += search_1D((SearchAlgorithm1D)a, first, last, keys[q]);
+                if(limit >= 0 && q % 16 == 15 && std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() > limit){
+                    t = -2;
+                    break;
+                }
+            }
+            double d = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / probes;
+            sink += found;
+            if(t != -2 && r > 0 && (t < 0 || d < t))
+                t = d;
+        }
+        if(t == -2){
+            plan.skipped[a] = "over budget";
+            continue;
+        }
+        plan.cost[a] = t;
+        if(best < 0 || t < best){
+            best = t;
+            plan.chosen = (SearchAlgorithm1D)a;
+        }
+    }
+    return plan;
+}
+
+
+/*! Two-dimensional search algorithms. */
+enum SearchAlgorithm2D{
+    SEARCH_SADDLEBACK = 0,
+    SEARCH_ROWS_BINARY,    /* std::binary_search on every row. */
+    SEARCH_COLUMNS_BINARY, /* binary_search: a binary search on every column. */
+    SEARCH_SHEN,
+    SEARCH_ALGORITHMS_2D
+};
+
+/*! Three-dimensional search algorithms. */
+enum SearchAlgorithm3D{
+    SEARCH_MAHL = 0,
+    SEARCH_LINIALSAKS,
+    SEARCH_ALGORITHMS_3D
+};
+
+inline const char* SearchAlgorithmName(SearchAlgorithm2D a){
+    static const char* names[SEARCH_ALGORITHMS_2D] = {"saddleback", "rows_binary", "columns_binary", "shen"};
+    return a >= 0 && a < SEARCH_ALGORITHMS_2D? names[a] : "unknown";
+}
+
+inline const char* SearchAlgorithmName(SearchAlgorithm3D a){
+    static const char* names[SEARCH_ALGORITHMS_3D] = {"mahl", "linialsaks"};
+    return a >= 0 && a < SEARCH_ALGORITHMS_3D? names[a] : "unknown";
+}
+
+/*!
+ * \brief Shape-based choice of the two- and three-dimensional searches, calibrated on this machine.
+ */
+class ShapeDispatcher{
+public:
+    ShapeDispatcher() : shen_leaf(4), mahl_leaf(3), calibrated(false){
+        /* Uncalibrated constants, in nanoseconds per model operation. */
+        for( int a = 0; a < SEARCH_ALGORITHMS_2D; ++a)
+            cost2[a] = 1;
+        for( int a = 0; a < SEARCH_ALGORITHMS_3D; ++a)
+            cost3[a] = 1;
+    }
+
+    /*!
+     * \brief Operations of algorithm a on an M x N array, according to its complexity.
+     */
+    static double operations_2D(SearchAlgorithm2D a, double M, double N){
+        double s = std::min(M, N), l = std::max(M, N);
+        switch(a){
+        case SEARCH_SADDLEBACK:
+            return M + N;
+        case SEARCH_ROWS_BINARY:
+            return M * std::log2(N + 1);
+        case SEARCH_COLUMNS_BINARY:
+            return N * std::log2(M + 1);
+        default:
+            return s * std::log2(2 * l / s) + 1;
+        }
+    }
+
+    /*!
+     * \brief Operations of algorithm a on an M x N x P array, according to its complexity.
+     */
+    static double operations_3D(SearchAlgorithm3D a, double M, double N, double P){
+        double d[3] = {M, N, P};
+        std::sort(d, d+3);
+        if(a == SEARCH_LINIALSAKS)
+            return M*N + N*P + M*P;
+        return d[0] * d[1] * std::log2(2 * d[2] / d[1]) + 1;
+    }
+
+    double predict_2D(SearchAlgorithm2D a, int M, int N) const{ return cost2[a] * operations_2D(a, M, N); }
+    double predict_3D(SearchAlgorithm3D a, int M, int N, int P) const{ return cost3[a] * operations_3D(a, M, N, P); }
+
+    SearchAlgorithm2D choose_2D(int M, int N) const{
+        SearchAlgorithm2D best = SEARCH_SADDLEBACK;
+        for( int a = 1; a < SEARCH_ALGORITHMS_2D; ++a)
+            if(predict_2D((SearchAlgorithm2D)a, M, N) < predict_2D(best, M, N))
+                best = (SearchAlgorithm2D)a;
+        return best;
+    }
+
+    SearchAlgorithm3D choose_3D(int M, int N, int P) const{
+        return predict_3D(SEARCH_LINIALSAKS, M, N, P) < predict_3D(SEARCH_MAHL, M, N, P)? SEARCH_LINIALSAKS : SEARCH_MAHL;
+    }
+
+    /*!
+     * \brief Searches a two-dimensional array with the algorithm chosen for its shape.
+     * \param first iterator to start of array.
+     * \param last iterator to end of array.
+     * \param  value is the search key.
+     */
+    template<class ForwardIt, class T>
+    bool search_2D(ForwardIt first, ForwardIt last, const T& value) const{
+        int M = last - first;
+        if(M == 0 || first[0].size() == 0)
+            return false;
+        return run_2D(choose_2D(M, first[0].size()), first, last, value);
+    }
+
+    /*!
+     * \brief Searches a three-dimensional array with the algorithm chosen for its shape.
+     * \param first iterator to start of array.
+     * \param last iterator to end of array.
+     * \param  value is the search key.
+     */
+    template<class ForwardIt, class T>
+    bool search_3D(ForwardIt first, ForwardIt last, const T& value) const{
+        int M = last - first;
+        if(M == 0 || first[0].size() == 0 || first[0][0].size() == 0)
+            return false;
+        return run_3D(choose_3D(M, first[0].size(), first[0][0].size()), first, last, value);
+    }
+
+    template<class ForwardIt, class T>
+    bool run_2D(SearchAlgorithm2D a, ForwardIt first, ForwardIt last, const T& value) const{
+        switch(a){
+        case SEARCH_SADDLEBACK:
+            return saddleback_search(first, last, value);
+        case SEARCH_ROWS_BINARY:
+            for( ForwardIt row = first; row != last; ++row)
+                if(std::binary_search((*row).begin(), (*row).end(), value))
+                    return true;
+            return false;
+        case SEARCH_COLUMNS_BINARY:
+            return binary_search(first, 0, 0, (int)(last - first) - 1, (int)first[0].size() - 1, value);
+        default:
+            return shen_search(first, last, value, shen_leaf);
+        }
+    }
+
+    template<class ForwardIt, class T>
+    bool run_3D(SearchAlgorithm3D a, ForwardIt first, ForwardIt last, const T& value) const{
+        if(a == SEARCH_LINIALSAKS)
+            return linialsaks_search(first, last, value);
+        return MAHL_e(first, last, value, mahl_leaf);
+    }
+
+    std::string explain_2D(int M, int N) const{
+        char buf[128];
+        std::snprintf(buf, sizeof(buf), "%d x %d%s:", M, N, calibrated? "" : " (not calibrated)");
+        std::string s = buf;
+        for( int a = 0; a < SEARCH_ALGORITHMS_2D; ++a){
+            std::snprintf(buf, sizeof(buf), " %s %.0f ns;", SearchAlgorithmName((SearchAlgorithm2D)a), predict_2D((SearchAlgorithm2D)a, M, N));
+            s += buf;
+        }
+        std::snprintf(buf, sizeof(buf), " chosen: %s (shen leaf %d)", SearchAlgorithmName(choose_2D(M, N)), shen_leaf);
+        return s + buf;
+    }
+
+    std::string explain_3D(int M, int N, int P) const{
+        char buf[128];
+        std::snprintf(buf, sizeof(buf), "%d x %d x %d%s:", M, N, P, calibrated? "" : " (not calibrated)");
+        std::string s = buf;
+        for( int a = 0; a < SEARCH_ALGORITHMS_3D; ++a){
+            std::snprintf(buf, sizeof(buf), " %s %.0f ns;", SearchAlgorithmName((SearchAlgorithm3D)a), predict_3D((SearchAlgorithm3D)a, M, N, P));
+            s += buf;
+        }
+        std::snprintf(buf, sizeof(buf), " chosen: %s (MAHL_e leaf %d)", SearchAlgorithmName(choose_3D(M, N, P)), mahl_leaf);
+        return s + buf;
+    }
+
+    /*!
+     * \brief Tunes the leaf sizes and fits the cost constants on generated instances.
+     */
+    void calibrate(){
+        static const int shapes2[3][2] = {{512, 512}, {32, 8192}, {8192, 32}};
+        static const int shapes3[3][3] = {{64, 64, 64}, {16, 64, 256}, {256, 16, 64}};
+        static const int leaves2[] = {2, 4, 8, 16, 32};
+        static const int leaves3[] = {2, 3, 4, 6, 8, 12};
+        std::vector<std::vector<std::vector<int> > > A2(3);
+        std::vector<std::vector<std::vector<std::vector<int> > > > A3(3);
+        std::vector<std::vector<int> > keys2(3), keys3(3);
+        for( int s = 0; s < 3; ++s){
+            int M = shapes2[s][0], N = shapes2[s][1];
+            A2[s].assign(M, std::vector<int>(N));
+            LinearIncreasingDistribution_2D(A2[s].begin(), A2[s].end(), 0, 1 << 24);
+            keys2[s] = probe_keys(A2[s][0][0], A2[s][M-1][N-1], s, [&](unsigned q){ return A2[s][q % M][(q * 7919) % N]; });
+            int P = shapes3[s][2];
+            M = shapes3[s][0];
+            N = shapes3[s][1];
+            A3[s].assign(M, std::vector<std::vector<int> >(N, std::vector<int>(P)));
+            LinearIncreasingDistribution_3D(A3[s].begin(), A3[s].end(), 0, 1 << 24);
+            keys3[s] = probe_keys(A3[s][0][0][0], A3[s][M-1][N-1][P-1], s, [&](unsigned q){ return A3[s][q % M][(q * 7919) % N][(q * 104729) % P]; });
+        }
+
+        /* Leaf sizes. */
+        double best = -1;
+        int tuned = shen_leaf;
+        for( std::size_t l = 0; l < sizeof(leaves2)/sizeof(leaves2[0]); ++l){
+            shen_leaf = leaves2[l];
+            double t = 0;
+            for( int s = 0; s < 3; ++s)
+                t += time_queries(keys2[s], [&](int v){ return run_2D(SEARCH_SHEN, A2[s].begin(), A2[s].end(), v); });
+            if(best < 0 || t < best){
+                best = t;
+                tuned = shen_leaf;
+            }
+        }
+        shen_leaf = tuned;
+        best = -1;
+        for( std::size_t l = 0; l < sizeof(leaves3)/sizeof(leaves3[0]); ++l){
+            mahl_leaf = leaves3[l];
+            double t = 0;
+            for( int s = 0; s < 3; ++s)
+                t += time_queries(keys3[s], [&](int v){ return run_3D(SEARCH_MAHL, A3[s].begin(), A3[s].end(), v); });
+            if(best < 0 || t < best){
+                best = t;
+                tuned = mahl_leaf;
+            }
+        }
+        mahl_leaf = tuned;
+
+        /* Least squares fit through the origin of time = cost * operations. */
+        for( int a = 0; a < SEARCH_ALGORITHMS_2D; ++a){
+            double to = 0, oo = 0;
+            for( int s = 0; s < 3; ++s){
+                double t = time_queries(keys2[s], [&](int v){ return run_2D((SearchAlgorithm2D)a, A2[s].begin(), A2[s].end(), v); });
+                double o = operations_2D((SearchAlgorithm2D)a, shapes2[s][0], shapes2[s][1]);
+                to += t * o;
+                oo += o * o;
+            }
+            cost2[a] = to / oo;
+        }
+        for( int a = 0; a < SEARCH_ALGORITHMS_3D; ++a){
+            double to = 0, oo = 0;
+            for( int s = 0; s < 3; ++s){
+                double t = time_queries(keys3[s], [&](int v){ return run_3D((SearchAlgorithm3D)a, A3[s].begin(), A3[s].end(), v); });
+                double o = operations_3D((SearchAlgorithm3D)a, shapes3[s][0], shapes3[s][1], shapes3[s][2]);
+                to += t * o;
+                oo += o * o;
+            }
+            cost3[a] = to / oo;
+        }
+        calibrated = true;
+    }
+
+    /*!
+     * \brief Reads a calibration saved by save. Returns false if the file is missing or invalid.
+     */
+    bool load(const char* path){
+        FILE* f = std::fopen(path, "r");
+        if(!f)
+            return false;
+        char name[64];
+        double v;
+        int version = 0, fields = 0;
+        while(std::fscanf(f, " %63s %lf", name, &v) == 2){
+            std::string key = name;
+            if(key == "version")
+                version = (int)v;
+            else if(key == "shen_leaf")
+                shen_leaf = (int)v, ++fields;
+            else if(key == "mahl_leaf")
+                mahl_leaf = (int)v, ++fields;
+            else{
+                for( int a = 0; a < SEARCH_ALGORITHMS_2D; ++a)
+                    if(key == SearchAlgorithmName((SearchAlgorithm2D)a))
+                        cost2[a] = v, ++fields;
+                for( int a = 0; a < SEARCH_ALGORITHMS_3D; ++a)
+                    if(key == SearchAlgorithmName((SearchAlgorithm3D)a))
+                        cost3[a] = v, ++fields;
+            }
+        }
+        std::fclose(f);
+        calibrated = version == SEARCH_CALIBRATION_VERSION && fields == 2 + SEARCH_ALGORITHMS_2D + SEARCH_ALGORITHMS_3D;
+        if(!calibrated)
+            *this = ShapeDispatcher();
+        return calibrated;
+    }
+
+    bool save(const char* path) const{
+        FILE* f = std::fopen(path, "w");
+        if(!f)
+            return false;
+        std::fprintf(f, "version %d\nshen_leaf %d\nmahl_leaf %d\n", SEARCH_CALIBRATION_VERSION, shen_leaf, mahl_leaf);
+        for( int a = 0; a < SEARCH_ALGORITHMS_2D; ++a)
+            std::fprintf(f, "%s %.6g\n", SearchAlgorithmName((SearchAlgorithm2D)a), cost2[a]);
+        for( int a = 0; a < SEARCH_ALGORITHMS_3D; ++a)
+            std::fprintf(f, "%s %.6g\n", SearchAlgorithmName((SearchAlgorithm3D)a), cost3[a]);
+        return std::fclose(f) == 0;
+    }
+
+    /*!
+     * \brief Loads the calibration from path, or calibrates and saves it there.
+     */
+    void load_or_calibrate(const char* path){
+        if(!load(path)){
+            calibrate();
+            save(path);
+        }
+    }
+
+    bool is_calibrated() const{ return calibrated; }
+
+    int shen_leaf, mahl_leaf;
+    double cost2[SEARCH_ALGORITHMS_2D]; /* Nanoseconds per operation of operations_2D. */
+    double cost3[SEARCH_ALGORITHMS_3D]; /* Nanoseconds per operation of operations_3D. */
+
+private:
+    /* Half hits, half keys spread over the range. */
+    template<class Hit>
+    static std::vector<int> probe_keys(int lo, int hi, int seed, Hit hit){
+        std::mt19937 rng(seed);
+        std::vector<int> keys(SEARCH_CALIBRATION_QUERIES);
+        for( int q = 0; q < SEARCH_CALIBRATION_QUERIES; ++q)
+            keys[q] = q % 2 == 0? hit(rng() % 65536) : lo + (int)(rng() % ((unsigned)(hi - lo) + 1));
+        return keys;
+    }
+
+    /* Nanoseconds per query, best of three rounds. */
+    template<class Search>
+    static double time_queries(const std::vector<int>& keys, Search search){
+        double best = -1;
+        volatile int sink = 0;
+        for( int r = 0; r < 3; ++r){
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            int found = 0;
+            for( std::size_t q = 0; q < keys.size(); ++q)
+                found += search(keys[q]);
+            double d = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / keys.size();
+            sink += found;
+            if(best < 0 || d < best)
+                best = d;
+        }
+        return best;
+    }
+
+    bool calibrated;
+};
+
+#endif
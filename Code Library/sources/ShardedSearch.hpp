@@ -0,0 +1,383 @@
+/** \file ShardedSearch.hpp
+ * Shared-nothing sharding of sorted 1D arrays and 2D matrices across worker processes.
+ */
+
+/*
+ *  ShardedSearch.hpp
+ *
+ *  Instituto de Informatica - UFG
+ *
+ */
+
+/*
+ * A sorted array is split in contiguous key ranges, and a matrix sorted along rows and columns in bands
+ * of consecutive rows. Each shard is sent to its own worker process over a Unix stream socket, so a
+ * worker owns a private copy of its part only and nothing is shared between workers. The router keeps
+ * the fence keys of every shard, its smallest and largest element: the first element of the band and the
+ * last element of its last row. Both fences grow with the shard number, so the shards that can contain a
+ * key are a contiguous range, found by two binary searches, and a key is sent only to those shards.
+ *
+ * Keys are sent in messages of up to SHARD_BATCH keys, one message per shard per round, and a worker
+ * reads a whole message before it answers; the router merges the answers by a logical or. Every shard
+ * runs any of the library searches on its own part, so the search algorithms are unchanged.
+ *
+ * shard_serve only needs a connected stream socket, so a worker on another host can serve a shard over
+ * TCP with the same protocol. Workers are started with fork(), so the router should be built before the
+ * process starts other threads.
+ */
+
+#ifndef ShardedSearch_hpp
+#define ShardedSearch_hpp
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "InstanceView.hpp"
+
+#define SHARD_BATCH (1 << 16) /* Keys per message. */
+
+/*!
+ * \brief Operation of a message from the router to a worker.
+ */
+enum ShardOp{
+    SHARD_LOAD = 1,  /* Followed by rows x cols elements, row by row. */
+    SHARD_QUERY = 2, /* Followed by count keys; answered by count bytes, 1 if the key was found. */
+    SHARD_QUIT = 3
+};
+
+/*!
+ * \brief Header of every message from the router to a worker.
+ */
+struct ShardMessage{
+    std::uint32_t op;
+    std::uint32_t element_size;
+    std::uint64_t rows;
+    std::uint64_t cols;
+    std::uint64_t count;
+};
+
+/*!
+ * \brief Writes bytes to a socket, retrying on partial writes.
+ */
+inline bool shard_send(int fd, const void* p, std::size_t bytes){
+    const char* c = (const char*)p;
+    while(bytes > 0){
+        ssize_t w = send(fd, c, bytes, MSG_NOSIGNAL);
+        if(w < 0 && errno == EINTR)
+            continue;
+        if(w <= 0)
+            return false;
+        c += w;
+        bytes -= w;
+    }
+    return true;
+}
+
+/*!
+ * \brief Reads exactly bytes from a socket.
+ * \return false on error or end of stream.
+ */
+inline bool shard_recv(int fd, void* p, std::size_t bytes){
+    char* c = (char*)p;
+    while(bytes > 0){
+        ssize_t r = recv(fd, c, bytes, 0);
+        if(r < 0 && errno == EINTR)
+            continue;
+        if(r <= 0)
+            return false;
+        c += r;
+        bytes -= r;
+    }
+    return true;
+}
+
+/*!
+ * \brief Worker loop: receives a shard and answers queries on it until SHARD_QUIT or end of stream.
+ * \param fd connected stream socket to the router.
+ * \param search search function, called as search(first, last, key) on the shard.
+ */
+template<class T, std::size_t D, class Search>
+void shard_serve(int fd, Search search){
+    static_assert(D == 1 || D == 2, "shards are one- or two-dimensional");
+    DenseArray<T, D> shard;
+    std::vector<T> keys;
+    std::vector<unsigned char> found;
+    ShardMessage msg;
+    bool loaded = false;
+    while(shard_recv(fd, &msg, sizeof(msg))){
+        if(msg.op == SHARD_LOAD){
+            if(msg.element_size != sizeof(T))
+                return;
+            typename DenseArray<T, D>::index_type ext;
+            ext[0] = msg.rows;
+            if constexpr (D == 2)
+                ext[1] = msg.cols;
+            shard = DenseArray<T, D>(ext);
+            if(!shard_recv(fd, shard.data(), msg.rows * msg.cols * sizeof(T)))
+                return;
+            loaded = msg.rows > 0 && msg.cols > 0;
+        }
+        else if(msg.op == SHARD_QUERY){
+            keys.resize(msg.count);
+            found.resize(msg.count);
+            if(!shard_recv(fd, keys.data(), msg.count * sizeof(T)))
+                return;
+            for( std::size_t q = 0; q < msg.count; ++q)
+                found[q] = loaded && search(shard.begin(), shard.end(), keys[q]);
+            if(!shard_send(fd, found.data(), msg.count))
+                return;
+        }
+        else
+            return;
+    }
+}
+
+/*!
+ * \brief Smallest and largest element of a shard.
+ */
+template<class T>
+struct ShardFence{
+    T low, high;
+};
+
+/*!
+ * \brief Router over a sorted 1D array or a 2D matrix sorted along rows and columns, split across
+ * worker processes.
+ *
+ * search(first, last, key) is any of the library searches, e.g.
+ * [](auto f, auto l, int v){ return saddleback_search(f, l, v); }.
+ */
+template<class T, std::size_t D, class Search>
+class ShardedSearch{
+    static_assert(D == 1 || D == 2, "ShardedSearch supports one or two dimensions");
+public:
+    /*!
+     * \brief Starts the workers and sends them their shards; check is_running() or error() afterwards.
+     * \param first iterator to start of array.
+     * \param last iterator to end of array.
+     * \param shards number of worker processes (at most one per element or row).
+     * \param search search function run by the workers.
+     */
+    template<class ForwardIt>
+    ShardedSearch(ForwardIt first, ForwardIt last, int shards, Search search) : msg(0){
+        std::int64_t n = last - first;
+        if(n <= 0 || shards <= 0){
+            msg = "empty instance or no shards";
+            return;
+        }
+        shards = (int)std::min<std::int64_t>(shards, n);
+        std::int64_t cols = 1;
+        if constexpr (D == 2)
+            cols = first[0].size();
+        for( int s = 0; s < shards; ++s){
+            std::int64_t lo = n * s / shards, hi = n * (s+1) / shards;
+            ShardFence<T> f;
+            if constexpr (D == 1){
+                f.low = first[lo];
+                f.high = first[hi-1];
+            }
+            else{
+                f.low = first[lo][0];
+                f.high = first[hi-1][cols-1];
+            }
+            fences.push_back(f);
+            lows.push_back(f.low);
+            highs.push_back(f.high);
+            if(!start(search)){
+                stop();
+                return;
+            }
+            if(!load(first, lo, hi, cols)){
+                msg = "cannot send shard to worker";
+                stop();
+                return;
+            }
+        }
+    }
+
+    ~ShardedSearch(){
+        stop();
+    }
+
+    ShardedSearch(const ShardedSearch&) = delete;
+    ShardedSearch& operator=(const ShardedSearch&) = delete;
+
+    bool is_running() const{ return !sockets.empty(); }
+    const char* error() const{ return msg; }
+    int shards() const{ return sockets.size(); }
+    const ShardFence<T>& fence(int shard) const{ return fences[shard]; }
+    pid_t worker(int shard) const{ return workers[shard]; }
+
+    /*!
+     * \brief Shards that can contain value: [begin, end) of the shard numbers.
+     */
+    void route(const T& value, int& begin, int& end) const{
+        begin = std::lower_bound(highs.begin(), highs.end(), value) - highs.begin();
+        end = std::upper_bound(lows.begin(), lows.end(), value) - lows.begin();
+    }
+
+    /*!
+     * \brief Searches count keys on the shards that can contain them.
+     * \param keys keys to search.
+     * \param count number of keys.
+     * \param results receives, for every key, whether it was found.
+     * \return false if a worker could not be reached.
+     */
+    bool search(const T* keys, std::size_t count, bool* results){
+        int S = sockets.size();
+        std::vector<std::vector<std::size_t> > routed(S);
+        for( std::size_t q = 0; q < count; ++q){
+            results[q] = false;
+            int b, e;
+            route(keys[q], b, e);
+            for( int s = b; s < e; ++s)
+                routed[s].push_back(q);
+        }
+        /* One message per shard per round: a worker answers only after it read its whole message, so
+           neither side can block on a full socket buffer while the other waits for it. */
+        std::vector<std::size_t> done(S, 0), sent(S, 0);
+        std::vector<T> buf;
+        std::vector<unsigned char> found;
+        for( bool more = true; more; ){
+            more = false;
+            for( int s = 0; s < S; ++s){
+                sent[s] = std::min<std::size_t>(SHARD_BATCH, routed[s].size() - done[s]);
+                if(sent[s] == 0)
+                    continue;
+                buf.resize(sent[s]);
+                for( std::size_t q = 0; q < sent[s]; ++q)
+                    buf[q] = keys[routed[s][done[s] + q]];
+                ShardMessage m = {SHARD_QUERY, sizeof(T), 0, 0, sent[s]};
+                if(!shard_send(sockets[s], &m, sizeof(m)) || !shard_send(sockets[s], buf.data(), sent[s] * sizeof(T))){
+                    msg = "cannot send keys to worker";
+                    return false;
+                }
+            }
+            for( int s = 0; s < S; ++s){
+                if(sent[s] == 0)
+                    continue;
+                found.resize(sent[s]);
+                if(!shard_recv(sockets[s], found.data(), sent[s])){
+                    msg = "worker did not answer";
+                    return false;
+                }
+                for( std::size_t q = 0; q < sent[s]; ++q)
+                    if(found[q])
+                        results[routed[s][done[s] + q]] = true;
+                done[s] += sent[s];
+                more = more || done[s] < routed[s].size();
+            }
+        }
+        return true;
+    }
+
+    /*!
+     * \brief Searches one key.
+     */
+    bool contains(const T& value){
+        bool found = false;
+        search(&value, 1, &found);
+        return found;
+    }
+
+private:
+    /*!
+     * \brief Forks a worker connected to a new socket.
+     */
+    bool start(Search search){
+        int sv[2];
+        if(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0){
+            msg = "socketpair failed";
+            return false;
+        }
+        pid_t pid = fork();
+        if(pid < 0){
+            close(sv[0]);
+            close(sv[1]);
+            msg = "fork failed";
+            return false;
+        }
+        if(pid == 0){
+            /* The worker keeps only its own socket, so the others see end of stream when the router closes them. */
+            close(sv[0]);
+            for( std::size_t s = 0; s < sockets.size(); ++s)
+                close(sockets[s]);
+            shard_serve<T, D>(sv[1], search);
+            close(sv[1]);
+            _exit(0);
+        }
+        close(sv[1]);
+        sockets.push_back(sv[0]);
+        workers.push_back(pid);
+        return true;
+    }
+
+    /*!
+     * \brief Sends rows (or elements) [lo, hi) to the last worker started.
+     */
+    template<class ForwardIt>
+    bool load(ForwardIt first, std::int64_t lo, std::int64_t hi, std::int64_t cols){
+        int fd = sockets.back();
+        ShardMessage m = {SHARD_LOAD, sizeof(T), (std::uint64_t)(hi - lo), (std::uint64_t)cols, 0};
+        if(!shard_send(fd, &m, sizeof(m)))
+            return false;
+        std::vector<T> buf;
+        if constexpr (D == 1){
+            for( std::int64_t i = lo; i < hi; i += SHARD_BATCH){
+                std::int64_t e = std::min<std::int64_t>(i + SHARD_BATCH, hi);
+                buf.assign(first + i, first + e);
+                if(!shard_send(fd, buf.data(), buf.size() * sizeof(T)))
+                    return false;
+            }
+        }
+        else{
+            for( std::int64_t i = lo; i < hi; ++i){
+                buf.assign(first[i].begin(), first[i].end());
+                if(!shard_send(fd, buf.data(), buf.size() * sizeof(T)))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    /*!
+     * \brief Tells the workers to quit and waits for them.
+     */
+    void stop(){
+        ShardMessage m = {SHARD_QUIT, sizeof(T), 0, 0, 0};
+        for( std::size_t s = 0; s < sockets.size(); ++s){
+            shard_send(sockets[s], &m, sizeof(m));
+            close(sockets[s]);
+        }
+        for( std::size_t s = 0; s < workers.size(); ++s)
+            while(waitpid(workers[s], 0, 0) < 0 && errno == EINTR)
+                ;
+        sockets.clear();
+        workers.clear();
+    }
+
+    std::vector<int> sockets;
+    std::vector<pid_t> workers;
+    std::vector<ShardFence<T> > fences;
+    std::vector<T> lows, highs;
+    const char* msg;
+};
+
+/*!
+ * \brief Builds a ShardedSearch.
+ */
+template<class T, std::size_t D, class ForwardIt, class Search>
+std::unique_ptr<ShardedSearch<T, D, Search> > make_sharded_search(ForwardIt first, ForwardIt last, int shards, Search search){
+    return std::unique_ptr<ShardedSearch<T, D, Search> >(new ShardedSearch<T, D, Search>(first, last, shards, search));
+}
+
+#endif
@@ -0,0 +1,220 @@
+/** \file ZoneMap.hpp
+ * Multi-resolution min/max summary of three-dimensional sorted arrays used to prune the 3D searches.
+ */
+
+/*
+ *  ZoneMap.hpp
+ *
+ *  Instituto de Informatica - UFG
+ *
+ */
+
+/*
+ * Level 0 stores the minimum and maximum of every block of B x B x B elements, level 1 of every block of
+ * (B*B)^3 elements and so on, up to a level with a single block. In a sorted array the minimum of a block is
+ * its first corner and the maximum its last corner, so the summary is built from corners only.
+ * A query descends from the top level into the blocks whose range contains the key: a key out of range or
+ * in a sparse region is rejected after a few lookups, and otherwise the search starts on the bounding box
+ * of the candidate blocks. MAHL_e also checks every box of its recursion against the summary, which lives
+ * in a few cache lines instead of in the array.
+ */
+
+#ifndef ZoneMap_hpp
+#define ZoneMap_hpp
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "SearchAlgorithms.hpp"
+
+/*!
+ * \brief Min/max pyramid of a three-dimensional sorted array.
+ */
+template<class T>
+class ZoneMap_3D{
+public:
+    ZoneMap_3D() : M(0), N(0), P(0), B(16){}
+
+    /*!
+     * \brief Builds the summary.
+     * \param first iterator to start of array.
+     * \param last iterator to end of array.
+     * \param block side of the level 0 blocks and fan-out between levels.
+     */
+    template<class ForwardIt>
+    ZoneMap_3D(ForwardIt first, ForwardIt last, std::ptrdiff_t block = 16) : B(block < 2? 2 : block){
+        M = last - first;
+        N = M > 0? first[0].size() : 0;
+        P = N > 0? first[0][0].size() : 0;
+        levels.clear();
+        if(M == 0 || N == 0 || P == 0)
+            return;
+        /* Level 0 from the corners of every block. */
+        Level l0;
+        l0.side = B;
+        l0.m = (M + B - 1) / B;
+        l0.n = (N + B - 1) / B;
+        l0.p = (P + B - 1) / B;
+        l0.mn.resize((std::size_t)l0.m*l0.n*l0.p);
+        l0.mx.resize(l0.mn.size());
+        for( std::ptrdiff_t a = 0; a < l0.m; ++a)
+            for( std::ptrdiff_t b = 0; b < l0.n; ++b)
+                for( std::ptrdiff_t c = 0; c < l0.p; ++c){
+                    std::size_t t = l0.index(a, b, c);
+                    l0.mn[t] = first[a*B][b*B][c*B];
+                    l0.mx[t] = first[std::min(M, (a+1)*B)-1][std::min(N, (b+1)*B)-1][std::min(P, (c+1)*B)-1];
+                }
+        levels.push_back(l0);
+        /* Coarser levels from their children. */
+        while(levels.back().m > 1 || levels.back().n > 1 || levels.back().p > 1){
+            const Level& f = levels.back();
+            Level l;
+            l.side = f.side * B;
+            l.m = (f.m + B - 1) / B;
+            l.n = (f.n + B - 1) / B;
+            l.p = (f.p + B - 1) / B;
+            l.mn.resize((std::size_t)l.m*l.n*l.p);
+            l.mx.resize(l.mn.size());
+            for( std::ptrdiff_t a = 0; a < l.m; ++a)
+                for( std::ptrdiff_t b = 0; b < l.n; ++b)
+                    for( std::ptrdiff_t c = 0; c < l.p; ++c){
+                        std::size_t t = l.index(a, b, c);
+                        l.mn[t] = f.mn[f.index(a*B, b*B, c*B)];
+                        l.mx[t] = f.mx[f.index(std::min(f.m, (a+1)*B)-1, std::min(f.n, (b+1)*B)-1, std::min(f.p, (c+1)*B)-1)];
+                    }
+            levels.push_back(l);
+        }
+    }
+
+    /*!
+     * \brief Bounding box of the level 0 blocks whose range contains value.
+     * \param  value is the search key.
+     * \return false if no block can contain value.
+     */
+    template<class Index>
+    bool candidate_region(const T& value, Index& i1, Index& j1, Index& k1, Index& in, Index& jn, Index& kn) const{
+        if(levels.empty())
+            return false;
+        std::ptrdiff_t box[6] = {M, N, P, -1, -1, -1};
+        descend((int)levels.size()-1, 0, 0, 0, value, box);
+        if(box[3] < 0)
+            return false;
+        i1 = (Index)box[0];
+        j1 = (Index)box[1];
+        k1 = (Index)box[2];
+        in = (Index)std::min(M-1, box[3]);
+        jn = (Index)std::min(N-1, box[4]);
+        kn = (Index)std::min(P-1, box[5]);
+        return true;
+    }
+
+    /*!
+     * \brief Cheap test of a box: false if the summary proves that value is not in it.
+     */
+    template<class Index>
+    bool may_contain(const T& value, Index i1, Index j1, Index k1, Index in, Index jn, Index kn) const{
+        const Level& l = levels[0];
+        return !(value < l.mn[l.index(i1/B, j1/B, k1/B)]) && !(l.mx[l.index(in/B, jn/B, kn/B)] < value);
+    }
+
+    /*!
+     * \brief Number of levels of the pyramid.
+     */
+    int depth() const{ return levels.size(); }
+
+    /*!
+     * \brief Bytes used by the summary.
+     */
+    std::size_t memory() const{
+        std::size_t s = 0;
+        for( std::size_t i = 0; i < levels.size(); ++i)
+            s += 2*levels[i].mn.size()*sizeof(T);
+        return s;
+    }
+
+private:
+    struct Level{
+        std::ptrdiff_t side; /* Elements per block side. */
+        std::ptrdiff_t m, n, p; /* Blocks per dimension. */
+        std::vector<T> mn, mx;
+        std::size_t index(std::ptrdiff_t a, std::ptrdiff_t b, std::ptrdiff_t c) const{ return ((std::size_t)a*n + b)*p + c; }
+    };
+
+    /* Visits the children of block (a, b, c) of level lv + 1, i.e. the blocks of level lv inside it. */
+    void descend(int lv, std::ptrdiff_t a, std::ptrdiff_t b, std::ptrdiff_t c, const T& value, std::ptrdiff_t* box) const{
+        const Level& l = levels[lv];
+        std::ptrdiff_t fa = lv+1 < (int)levels.size()? B : l.m, fb = lv+1 < (int)levels.size()? B : l.n, fc = lv+1 < (int)levels.size()? B : l.p;
+        for( std::ptrdiff_t x = a*fa; x < std::min(l.m, (a+1)*fa); ++x){
+            if(value < l.mn[l.index(x, b*fb, c*fc)])
+                break;
+            for( std::ptrdiff_t y = b*fb; y < std::min(l.n, (b+1)*fb); ++y){
+                if(value < l.mn[l.index(x, y, c*fc)])
+                    break;
+                for( std::ptrdiff_t z = c*fc; z < std::min(l.p, (c+1)*fc); ++z){
+                    std::size_t t = l.index(x, y, z);
+                    if(value < l.mn[t])
+                        break;
+                    if(l.mx[t] < value)
+                        continue;
+                    if(lv == 0){
+                        box[0] = std::min(box[0], x*l.side);
+                        box[1] = std::min(box[1], y*l.side);
+                        box[2] = std::min(box[2], z*l.side);
+                        box[3] = std::max(box[3], (x+1)*l.side - 1);
+                        box[4] = std::max(box[4], (y+1)*l.side - 1);
+                        box[5] = std::max(box[5], (z+1)*l.side - 1);
+                    }else
+                        descend(lv-1, x, y, z, value, box);
+                }
+            }
+        }
+    }
+
+    std::ptrdiff_t M, N, P, B;
+    std::vector<Level> levels; /* levels[0] is the finest. */
+};
+
+
+/*!
+ * \brief MAHL_e function that starts on the candidate region of a zone map.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ * \param zm zone map of the same array; every box of the recursion is checked against it.
+ * \param leaf boxes with a dimension of at most leaf (at least 2) are searched by saddleback.
+ */
+template<class ForwardIt, class T, class U>
+bool MAHL_e(ForwardIt first, ForwardIt last, const T& value, const ZoneMap_3D<U>& zm, int leaf = 3){
+    std::ptrdiff_t m = last - first, n = m > 0? first[0].size() : 0, p = n > 0? first[0][0].size() : 0;
+    return index_dispatch(std::max(m, std::max(n, p)), [&](auto size){
+        typedef decltype(size) Index;
+        Index i1, j1, k1, im, jn, kp;
+        if(!zm.candidate_region(value, i1, j1, k1, im, jn, kp))
+            return false;
+        return MAHL_e(first, i1, j1, k1, im, jn, kp, value, leaf < 2? 2 : leaf, [&zm](const T& v, Index a1, Index b1, Index c1, Index am, Index bn, Index cp){
+            return zm.may_contain(v, a1, b1, c1, am, bn, cp);
+        });
+    });
+}
+
+/*!
+ * \brief Linial and Saks search function that starts on the candidate region of a zone map.
+ * \param first iterator to start of array.
+ * \param last iterator to end of array.
+ * \param  value is the search key.
+ * \param zm zone map of the same array.
+ */
+template<class ForwardIt, class T, class U>
+bool linialsaks_search(ForwardIt first, ForwardIt last, const T& value, const ZoneMap_3D<U>& zm){
+    std::ptrdiff_t m = last - first, n = m > 0? first[0].size() : 0, p = n > 0? first[0][0].size() : 0;
+    return index_dispatch(std::max(m, std::max(n, p)), [&](auto size){
+        typedef decltype(size) Index;
+        Index i1, j1, k1, in, jn, kn;
+        if(!zm.candidate_region(value, i1, j1, k1, in, jn, kn))
+            return false;
+        return linialsaks_search(first, i1, j1, k1, in, jn, kn, value);
+    });
+}
+
+#endif